@@ -7,6 +7,9 @@
  * @date 20120728 - Game Control fixes needed for multiplayer to work correctly
  * @date 20120730 - Improved network synchronization for multiplayer game play
  * @date 20120910 - Fix SFML v1.6 issues
+ * @date 20261016 - Interpolate player positions between fixed updates
+ * @date 20261016 - Simulate one game tick every fixed update
+ * @date 20261016 - Predict remote input and roll back on late input
  */
 #include "GameState.hpp"
 #include <SFML/Network.hpp>
@@ -27,7 +30,7 @@ GameState::GameState(TnTApp& theApp) :
     "resources/arial.ttf",
     32,  // each screen is 32 tiles across
     24), // each screen is 24 tiles down
-  mNetworkSystem(theApp),
+  mNetworkSystem(theApp, mLevelSystem),
   mPlayer("player",100),
   mPlayerID(0),
   mPlayerImages(NULL)
@@ -177,10 +180,15 @@ void GameState::UpdateFixed(void)
   mNetworkSystem.UpdateFixed();
   mAnimationSystem.UpdateFixed();
   mLevelSystem.UpdateFixed();
+
+  // Commit and send the input of our local players for the next game tick
+  mNetworkSystem.CommitLocalInput();
 }
 
 void GameState::UpdateVariable(float theElapsedTime)
 {
+  // Let our LevelSystem interpolate player positions at the display rate
+  mLevelSystem.UpdateVariable(theElapsedTime);
 }
 
 void GameState::Draw(void)
@@ -0,0 +1,112 @@
+/**
+ * Provides the LevelArena class which holds every allocation that lives as
+ * long as the level it was made for and releases them all at once.
+ *
+ * @file src/LevelArena.cpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ */
+#include "LevelArena.hpp"
+#include <cstring>
+#include <new>
+#include <GQE/Core/loggers/Log_macros.hpp>
+
+LevelArena::LevelArena() :
+  mBlocks(NULL),
+  mNext(NULL),
+  mLeft(0),
+  mSize(0)
+{
+}
+
+LevelArena::~LevelArena()
+{
+  // Free every block still held by this arena
+  Release();
+}
+
+void* LevelArena::Allocate(std::size_t theSize)
+{
+  // Round theSize up so the next allocation stays aligned
+  const std::size_t anAlign = sizeof(double);
+  const std::size_t anSize = (theSize + anAlign - 1) & ~(anAlign - 1);
+
+  // Do we need another block for this allocation? (even empty ones get one)
+  if(anSize > mLeft || mBlocks == NULL)
+  {
+    // Each block is twice the size of the previous one
+    std::size_t anBlockSize = (mBlocks != NULL) ? mBlocks->size * 2 : BLOCK_SIZE;
+    while(anBlockSize < anSize + sizeof(Block))
+    {
+      anBlockSize *= 2;
+    }
+
+    char* anMemory = new(std::nothrow) char[anBlockSize];
+    if(anMemory == NULL)
+    {
+      ELOG() << "LevelArena::Allocate(" << theSize
+        << ") Unable to allocate block!" << std::endl;
+
+      // Let the caller know we are out of memory
+      return NULL;
+    }
+
+    // Link the new block in front of the previous blocks
+    Block* anBlock = reinterpret_cast<Block*>(anMemory);
+    anBlock->next = mBlocks;
+    anBlock->size = anBlockSize;
+    mBlocks = anBlock;
+    mNext = anMemory + sizeof(Block);
+    mLeft = anBlockSize - sizeof(Block);
+    mSize += anBlockSize;
+  }
+
+  // Hand out the next anSize bytes of the current block
+  void* anResult = mNext;
+  mNext += anSize;
+  mLeft -= anSize;
+
+  // Every allocation starts out zero filled
+  std::memset(anResult, 0, anSize);
+
+  return anResult;
+}
+
+void LevelArena::Release(void)
+{
+  // Free each block, newest first
+  while(mBlocks != NULL)
+  {
+    Block* anBlock = mBlocks;
+    mBlocks = anBlock->next;
+    delete[] reinterpret_cast<char*>(anBlock);
+  }
+
+  // Don't keep addresses we have deleted around
+  mNext = NULL;
+  mLeft = 0;
+  mSize = 0;
+}
+
+void LevelArena::Swap(LevelArena& theOther)
+{
+  Block* anBlocks = mBlocks;
+  char* anNext = mNext;
+  std::size_t anLeft = mLeft;
+  std::size_t anSize = mSize;
+
+  mBlocks = theOther.mBlocks;
+  mNext = theOther.mNext;
+  mLeft = theOther.mLeft;
+  mSize = theOther.mSize;
+
+  theOther.mBlocks = anBlocks;
+  theOther.mNext = anNext;
+  theOther.mLeft = anLeft;
+  theOther.mSize = anSize;
+}
+
+std::size_t LevelArena::GetSize(void) const
+{
+  return mSize;
+}
@@ -0,0 +1,136 @@
+/**
+ * Provides the LevelArena class which holds every allocation that lives as
+ * long as the level it was made for and releases them all at once.
+ *
+ * @file src/LevelArena.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ */
+#ifndef LEVEL_ARENA_HPP_INCLUDED
+#define LEVEL_ARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <GQE/Core/Core_types.hpp>
+
+/// Provides the level lifetime arena allocator class
+class LevelArena
+{
+  public:
+    /// The size in bytes of the first block allocated by each LevelArena
+    static const std::size_t BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * LevelArena default constructor
+     */
+    LevelArena();
+
+    /**
+     * LevelArena deconstructor
+     */
+    ~LevelArena();
+
+    /**
+     * Allocate is responsible for returning theSize bytes of zero filled
+     * memory from this arena. The memory is suitably aligned for any of the
+     * plain structs used by a level and remains valid until Release is called.
+     * @param[in] theSize in bytes to allocate
+     * @return pointer to the memory allocated or NULL if out of memory
+     */
+    void* Allocate(std::size_t theSize);
+
+    /**
+     * Allocate is responsible for returning theCount zero filled TYPE values
+     * from this arena. TYPE must be a plain struct, no constructor or
+     * destructor will ever be called for it.
+     * @param[in] theCount of TYPE values to allocate
+     * @return pointer to the first TYPE value or NULL if out of memory
+     */
+    template<class TYPE>
+    TYPE* Allocate(std::size_t theCount)
+    {
+      return static_cast<TYPE*>(Allocate(theCount * sizeof(TYPE)));
+    }
+
+    /**
+     * Release is responsible for freeing everything allocated from this
+     * arena at once. Since each block is twice the size of the previous one
+     * only a handful of blocks are ever freed no matter how large the level.
+     */
+    void Release(void);
+
+    /**
+     * Swap is responsible for exchanging every allocation of this arena with
+     * theOther arena provided without copying anything.
+     * @param[in] theOther arena to swap with
+     */
+    void Swap(LevelArena& theOther);
+
+    /**
+     * GetSize returns the number of bytes currently held by this arena
+     * @return the total size in bytes of every block allocated
+     */
+    std::size_t GetSize(void) const;
+
+  private:
+    // Structs
+    ///////////////////////////////////////////////////////////////////////////
+    /// Header at the start of every block allocated by the arena
+    struct Block {
+      Block*      next;        ///< The previously allocated block or NULL
+      std::size_t size;        ///< The size of this block including this header
+      double      align;       ///< Makes sure the memory after this header is aligned
+    };
+
+    // Variables
+    ///////////////////////////////////////////////////////////////////////////
+    /// The most recently allocated block or NULL if nothing was allocated
+    Block*        mBlocks;
+    /// The next free byte in mBlocks
+    char*         mNext;
+    /// The number of free bytes left in mBlocks
+    std::size_t   mLeft;
+    /// The total size in bytes of every block allocated
+    std::size_t   mSize;
+
+    /**
+     * LevelArena copy constructor is private because we do not allow copies
+     * of our arena.
+     */
+    LevelArena(const LevelArena&);
+
+    /**
+     * LevelArena assignment operator is private because we do not allow
+     * copies of our arena.
+     */
+    LevelArena& operator=(const LevelArena&);
+}; // class LevelArena
+#endif // LEVEL_ARENA_HPP_INCLUDED
+
+/**
+ * @class LevelArena
+ * @ingroup Examples
+ * @section DESCRIPTION
+ * The LevelArena class is a simple bump allocator for everything that lives
+ * exactly as long as a single level, such as the screens, tile cells and the
+ * wall and treasure lists of each screen. Nothing is ever freed on its own,
+ * instead the whole arena is released at once when the level is unloaded.
+ * Each new block is twice as large as the previous one, so a level only
+ * needs a few blocks and releasing it costs next to nothing.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
@@ -0,0 +1,71 @@
+/**
+ * Provides the Level Asset type used by the AssetManager for managing compiled
+ * level files built from the TMX files created by the Tiled map editor.
+ *
+ * @file src/LevelAsset.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ */
+#ifndef LEVEL_ASSET_HPP_INCLUDED
+#define LEVEL_ASSET_HPP_INCLUDED
+#include <GQE/Core/interfaces/TAsset.hpp>
+#include "LevelMap.hpp"
+
+/// Provides the Level asset class
+class LevelAsset : public GQE::TAsset<LevelMap>
+{
+  public:
+    /**
+     * LevelAsset default constructor is used when you don't know the asset
+     * filename until later.
+     */
+    LevelAsset();
+
+    /**
+     * LevelAsset constructor
+     * @param[in] theAssetID to uniquely identify this asset
+     * @param[in] theLoadTime (Now, Later) of when to load this asset
+     * @param[in] theLoadStyle (File, Mem, Network) to use when loading this asset
+     * @param[in] theDropTime at (Zero, Exit) for when to unload this asset
+     */
+    LevelAsset(const GQE::typeAssetID theAssetID,
+        GQE::AssetLoadTime theLoadTime = GQE::AssetLoadLater,
+        GQE::AssetLoadStyle theLoadStyle = GQE::AssetLoadFromFile,
+        GQE::AssetDropTime theDropTime = GQE::AssetDropAtZero);
+
+    /**
+     * LevelAsset deconstructor
+     */
+    virtual ~LevelAsset();
+
+  protected:
+
+  private:
+    // Variables
+    ///////////////////////////////////////////////////////////////////////////
+}; // class LevelAsset
+#endif // LEVEL_ASSET_HPP_INCLUDED
+/**
+ * @class LevelAsset
+ * @ingroup Examples
+ * @section DESCRIPTION
+ * The LevelAsset class is responsible for loading a compiled level file which
+ * is built from a TMX map file created by the Tiled map editor, see LevelMap.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
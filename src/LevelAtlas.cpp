@@ -0,0 +1,516 @@
+/**
+ * Provides the LevelAtlas class which packs every tileset image of a level
+ * into a few atlas textures so the tiles of a screen share their textures.
+ *
+ * @file src/LevelAtlas.cpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Apply tileset colour keys and find opaque tiles
+ * @date 20261016 - Validate every cached placement against its page
+ */
+#include "LevelAtlas.hpp"
+#include "LevelMap.hpp"
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <GQE/Core/loggers/Log_macros.hpp>
+
+/// Header at the start of every atlas cache file
+struct AtlasHeader {
+  GQE::Uint32 magic;           ///< Always LevelAtlas::MAGIC
+  GQE::Uint32 version;         ///< Always LevelAtlas::VERSION
+  GQE::Uint32 key;             ///< Hash of every tileset image used
+  GQE::Uint32 pages;           ///< Number of atlas page images
+  GQE::Uint32 count;           ///< Number of Placement records that follow
+};
+
+/// Helper used by Create to sort the tileset images tallest first
+struct AtlasTaller
+{
+  const std::vector<sf::Vector2u>& mSizes;
+  AtlasTaller(const std::vector<sf::Vector2u>& theSizes) : mSizes(theSizes) {}
+  bool operator()(GQE::Uint32 theLeft, GQE::Uint32 theRight) const
+  {
+    return mSizes[theLeft].y > mSizes[theRight].y;
+  }
+};
+
+LevelAtlas::LevelAtlas() :
+  mPages(NULL),
+  mNumPages(0),
+#if (SFML_VERSION_MAJOR >= 2)
+  mImages(NULL)
+#else
+  mImages(false)
+#endif
+{
+}
+
+LevelAtlas::~LevelAtlas()
+{
+  // Delete our page images and atlas pages
+  DropImages();
+  delete[] mPages;
+
+  // Don't keep addresses we have deleted around
+  mPages = NULL;
+}
+
+bool LevelAtlas::Create(const std::string theFilename,
+    const std::vector<std::string>& theSources,
+    const std::vector<GQE::Uint32>& theColorKeys)
+{
+  // Delete any previous atlas pages first
+  DropImages();
+  delete[] mPages;
+  mPages = NULL;
+  mNumPages = 0;
+  mPlacements.clear();
+
+  // Compute our cache key from the contents and colour key of every tileset image
+  GQE::Uint32 anKey = 2166136261U;
+  for(size_t i = 0; i < theSources.size(); i++)
+  {
+    anKey = HashFile(theSources[i], anKey);
+    GQE::Uint32 anColorKey = LevelMap::NO_COLOR_KEY;
+    if(i < theColorKeys.size())
+    {
+      anColorKey = theColorKeys[i];
+    }
+    for(GQE::Uint32 anByte = 0; anByte < 4; anByte++)
+    {
+      anKey = (anKey ^ ((anColorKey >> (anByte * 8)) & 0xFF)) * 16777619U;
+    }
+  }
+
+  // Use the cached atlas if it was made from the same tileset images
+  std::string anCacheFilename = GetCacheFilename(theFilename);
+  if(LoadCache(anCacheFilename, anKey, (GQE::Uint32)theSources.size()))
+  {
+    return true;
+  }
+
+  // Load each tileset image
+  std::vector<sf::Image> anImages(theSources.size());
+  std::vector<sf::Vector2u> anSizes(theSources.size());
+  for(size_t i = 0; i < theSources.size(); i++)
+  {
+#if (SFML_VERSION_MAJOR < 2)
+    if(anImages[i].LoadFromFile(theSources[i]) == false)
+#else
+    if(anImages[i].loadFromFile(theSources[i]) == false)
+#endif
+    {
+      ELOG() << "LevelAtlas::Create(" << theFilename << ") Unable to load tileset "
+        << theSources[i] << std::endl;
+      return false;
+    }
+
+    // Pixels matching the colour key of the tileset become transparent
+    if(i < theColorKeys.size() && theColorKeys[i] != LevelMap::NO_COLOR_KEY)
+    {
+      const sf::Color anColor((theColorKeys[i] >> 16) & 0xFF,
+        (theColorKeys[i] >> 8) & 0xFF, theColorKeys[i] & 0xFF);
+#if (SFML_VERSION_MAJOR < 2)
+      anImages[i].CreateMaskFromColor(anColor);
+#else
+      anImages[i].createMaskFromColor(anColor);
+#endif
+    }
+#if (SFML_VERSION_MAJOR < 2)
+    anSizes[i] = sf::Vector2u(anImages[i].GetWidth(), anImages[i].GetHeight());
+#else
+    anSizes[i] = anImages[i].getSize();
+#endif
+  }
+
+  // Pack the tallest tileset images first, left to right on each shelf
+  std::vector<GQE::Uint32> anOrder(theSources.size());
+  for(size_t i = 0; i < anOrder.size(); i++)
+  {
+    anOrder[i] = (GQE::Uint32)i;
+  }
+  std::stable_sort(anOrder.begin(), anOrder.end(), AtlasTaller(anSizes));
+
+  Placement anEmpty = {0, 0, 0, 0, 0};
+  mPlacements.assign(theSources.size(), anEmpty);
+  std::vector<sf::Vector2u> anPageSizes(1, sf::Vector2u(0, 0));
+  GQE::Uint32 anX = 0;
+  GQE::Uint32 anY = 0;
+  GQE::Uint32 anShelf = 0;
+  for(size_t i = 0; i < anOrder.size(); i++)
+  {
+    const sf::Vector2u& anSize = anSizes[anOrder[i]];
+
+    // Start a new shelf if this image doesn't fit on the current one
+    if(anX > 0 && anX + anSize.x > PAGE_SIZE)
+    {
+      anY += anShelf;
+      anX = 0;
+      anShelf = 0;
+    }
+
+    // Start a new page if this image doesn't fit on the current one
+    if(anY > 0 && anY + anSize.y > PAGE_SIZE)
+    {
+      anPageSizes.push_back(sf::Vector2u(0, 0));
+      anY = 0;
+    }
+
+    // Place the image and grow the page to hold it
+    Placement& anPlacement = mPlacements[anOrder[i]];
+    anPlacement.page = (GQE::Uint32)anPageSizes.size() - 1;
+    anPlacement.x = anX;
+    anPlacement.y = anY;
+    anPlacement.width = anSize.x;
+    anPlacement.height = anSize.y;
+    anPageSizes.back().x = std::max(anPageSizes.back().x, anX + anSize.x);
+    anPageSizes.back().y = std::max(anPageSizes.back().y, anY + anSize.y);
+    anX += anSize.x;
+    anShelf = std::max(anShelf, anSize.y);
+  }
+
+  // Create each atlas page from the tileset images placed on it
+  mNumPages = (GQE::Uint32)anPageSizes.size();
+  mPages = new(std::nothrow) typeAtlasPage[mNumPages];
+#if (SFML_VERSION_MAJOR >= 2)
+  mImages = new(std::nothrow) sf::Image[mNumPages];
+  if(mPages == NULL || mImages == NULL)
+#else
+  mImages = true;
+  if(mPages == NULL)
+#endif
+  {
+    ELOG() << "LevelAtlas::Create(" << theFilename << ") Unable to create atlas pages!"
+      << std::endl;
+    DropImages();
+    delete[] mPages;
+    mPages = NULL;
+    mNumPages = 0;
+    return false;
+  }
+
+  bool anSaved = true;
+  for(GQE::Uint32 anPage = 0; anPage < mNumPages; anPage++)
+  {
+    sf::Image anImage;
+#if (SFML_VERSION_MAJOR < 2)
+    anImage.Create(anPageSizes[anPage].x, anPageSizes[anPage].y, sf::Color(0, 0, 0, 0));
+#else
+    anImage.create(anPageSizes[anPage].x, anPageSizes[anPage].y, sf::Color(0, 0, 0, 0));
+#endif
+    for(size_t i = 0; i < mPlacements.size(); i++)
+    {
+      if(mPlacements[i].page == anPage)
+      {
+#if (SFML_VERSION_MAJOR < 2)
+        anImage.Copy(anImages[i], mPlacements[i].x, mPlacements[i].y);
+#else
+        anImage.copy(anImages[i], mPlacements[i].x, mPlacements[i].y);
+#endif
+      }
+    }
+
+    // Write the page to our cache and turn it into a texture
+#if (SFML_VERSION_MAJOR < 2)
+    anSaved = anImage.SaveToFile(GetPageFilename(anCacheFilename, anPage)) && anSaved;
+    mPages[anPage] = anImage;
+    mPages[anPage].SetSmooth(false);
+#else
+    anSaved = anImage.saveToFile(GetPageFilename(anCacheFilename, anPage)) && anSaved;
+    mPages[anPage].loadFromImage(anImage);
+    mImages[anPage] = anImage;
+#endif
+  }
+
+  // Only write the cache file once every page image was written
+  if(anSaved == false || SaveCache(anCacheFilename, anKey) == false)
+  {
+    WLOG() << "LevelAtlas::Create(" << theFilename << ") Unable to write atlas cache "
+      << anCacheFilename << std::endl;
+  }
+
+  ILOG() << "LevelAtlas::Create(" << theFilename << ") Packed " << theSources.size()
+    << " tilesets into " << mNumPages << " atlas pages" << std::endl;
+
+  // Every tileset image was placed
+  return true;
+}
+
+GQE::Uint32 LevelAtlas::GetNumPages(void) const
+{
+  return mNumPages;
+}
+
+const LevelAtlas::typeAtlasPage& LevelAtlas::GetPage(GQE::Uint32 theIndex) const
+{
+  return mPages[theIndex];
+}
+
+const LevelAtlas::Placement& LevelAtlas::GetPlacement(GQE::Uint32 theTileset) const
+{
+  return mPlacements[theTileset];
+}
+
+bool LevelAtlas::IsOpaque(GQE::Uint32 theTileset, GQE::Uint32 theLeft, GQE::Uint32 theTop,
+    GQE::Uint32 theWidth, GQE::Uint32 theHeight) const
+{
+  // Without the page images or a valid tileset we can't tell, assume not
+  if(!mImages || theTileset >= mPlacements.size() || theWidth == 0 || theHeight == 0)
+  {
+    return false;
+  }
+
+  // The rectangle must be entirely inside the tileset image
+  const Placement& anPlacement = mPlacements[theTileset];
+  if(theLeft > anPlacement.width || theWidth > anPlacement.width - theLeft ||
+      theTop > anPlacement.height || theHeight > anPlacement.height - theTop)
+  {
+    return false;
+  }
+
+#if (SFML_VERSION_MAJOR < 2)
+  const sf::Image& anImage = mPages[anPlacement.page];
+  const GQE::Uint32 anWidth = anImage.GetWidth();
+  const GQE::Uint32 anHeight = anImage.GetHeight();
+  const sf::Uint8* anPixels = anImage.GetPixelsPtr();
+#else
+  const sf::Image& anImage = mImages[anPlacement.page];
+  const GQE::Uint32 anWidth = anImage.getSize().x;
+  const GQE::Uint32 anHeight = anImage.getSize().y;
+  const sf::Uint8* anPixels = anImage.getPixelsPtr();
+#endif
+
+  // The rectangle must be entirely on the page
+  const GQE::Uint32 anLeft = anPlacement.x + theLeft;
+  const GQE::Uint32 anTop = anPlacement.y + theTop;
+  if(anPixels == NULL || anLeft + theWidth > anWidth || anTop + theHeight > anHeight)
+  {
+    return false;
+  }
+
+  // Look at the alpha value of every pixel, RGBA with 4 bytes each
+  for(GQE::Uint32 anY = anTop; anY < anTop + theHeight; anY++)
+  {
+    const sf::Uint8* anRow = anPixels + (anY * anWidth + anLeft) * 4;
+    for(GQE::Uint32 anX = 0; anX < theWidth; anX++)
+    {
+      if(anRow[anX * 4 + 3] != 255)
+      {
+        return false;
+      }
+    }
+  }
+
+  // Every pixel was opaque
+  return true;
+}
+
+void LevelAtlas::DropImages(void)
+{
+#if (SFML_VERSION_MAJOR >= 2)
+  // Delete our page images, the textures are all we need to draw
+  delete[] mImages;
+
+  // Don't keep addresses we have deleted around
+  mImages = NULL;
+#else
+  // Our pages are images, just stop using them for IsOpaque
+  mImages = false;
+#endif
+}
+
+std::string LevelAtlas::GetCacheFilename(const std::string theFilename)
+{
+  // Find the extension which must come after the last path separator
+  std::string::size_type anSlash = theFilename.find_last_of("/\\");
+  std::string::size_type anDot = theFilename.find_last_of('.');
+
+  // Strip the extension if one was found
+  std::string anResult(theFilename);
+  if(anDot != std::string::npos && (anSlash == std::string::npos || anDot > anSlash))
+  {
+    anResult.erase(anDot);
+  }
+
+  // Add our atlas cache extension
+  anResult.append(".atlas");
+
+  return anResult;
+}
+
+bool LevelAtlas::LoadCache(const std::string theFilename, GQE::Uint32 theKey,
+    GQE::Uint32 theCount)
+{
+  std::ifstream anFile(theFilename.c_str(), std::ios::in | std::ios::binary);
+  if(anFile.is_open() == false)
+  {
+    return false;
+  }
+
+  // Make sure the cache file was made from the same tileset images, every
+  // page holds at least one tileset image (or is the only page)
+  AtlasHeader anHeader;
+  anFile.read((char*)&anHeader, sizeof(AtlasHeader));
+  if(anFile.fail() || anHeader.magic != MAGIC || anHeader.version != VERSION ||
+      anHeader.key != theKey || anHeader.count != theCount || anHeader.pages == 0 ||
+      anHeader.pages > std::max(theCount, (GQE::Uint32)1))
+  {
+    return false;
+  }
+
+  // Read where each tileset image was placed
+  Placement anEmpty = {0, 0, 0, 0, 0};
+  std::vector<Placement> anPlacements(theCount, anEmpty);
+  if(theCount > 0)
+  {
+    anFile.read((char*)&anPlacements[0], theCount * sizeof(Placement));
+  }
+  if(anFile.fail())
+  {
+    return false;
+  }
+
+  // Every tileset image must be on one of the pages
+  for(GQE::Uint32 i = 0; i < theCount; i++)
+  {
+    if(anPlacements[i].page >= anHeader.pages)
+    {
+      WLOG() << "LevelAtlas::LoadCache(" << theFilename << ") Invalid page for tileset "
+        << i << ", making the atlas again" << std::endl;
+      return false;
+    }
+  }
+
+  // Load each atlas page image
+  typeAtlasPage* anPages = new(std::nothrow) typeAtlasPage[anHeader.pages];
+#if (SFML_VERSION_MAJOR >= 2)
+  sf::Image* anImages = new(std::nothrow) sf::Image[anHeader.pages];
+  if(anPages == NULL || anImages == NULL)
+  {
+    delete[] anPages;
+    delete[] anImages;
+    return false;
+  }
+#else
+  if(anPages == NULL)
+  {
+    return false;
+  }
+#endif
+  for(GQE::Uint32 anPage = 0; anPage < anHeader.pages; anPage++)
+  {
+#if (SFML_VERSION_MAJOR < 2)
+    if(anPages[anPage].LoadFromFile(GetPageFilename(theFilename, anPage)) == false)
+#else
+    if(anImages[anPage].loadFromFile(GetPageFilename(theFilename, anPage)) == false ||
+        anPages[anPage].loadFromImage(anImages[anPage]) == false)
+#endif
+    {
+      delete[] anPages;
+#if (SFML_VERSION_MAJOR >= 2)
+      delete[] anImages;
+#endif
+      return false;
+    }
+#if (SFML_VERSION_MAJOR < 2)
+    anPages[anPage].SetSmooth(false);
+#endif
+  }
+
+  // Every tileset image must lie entirely on its page
+  for(GQE::Uint32 i = 0; i < theCount; i++)
+  {
+    const Placement& anPlacement = anPlacements[i];
+#if (SFML_VERSION_MAJOR < 2)
+    const GQE::Uint32 anWidth = anPages[anPlacement.page].GetWidth();
+    const GQE::Uint32 anHeight = anPages[anPlacement.page].GetHeight();
+#else
+    const GQE::Uint32 anWidth = anImages[anPlacement.page].getSize().x;
+    const GQE::Uint32 anHeight = anImages[anPlacement.page].getSize().y;
+#endif
+    if(anPlacement.x > anWidth || anPlacement.width > anWidth - anPlacement.x ||
+        anPlacement.y > anHeight || anPlacement.height > anHeight - anPlacement.y)
+    {
+      WLOG() << "LevelAtlas::LoadCache(" << theFilename << ") Tileset " << i
+        << " is outside of its page, making the atlas again" << std::endl;
+      delete[] anPages;
+#if (SFML_VERSION_MAJOR >= 2)
+      delete[] anImages;
+#endif
+      return false;
+    }
+  }
+
+  // Use the cached atlas
+  mPages = anPages;
+  mNumPages = anHeader.pages;
+  mPlacements.swap(anPlacements);
+#if (SFML_VERSION_MAJOR >= 2)
+  mImages = anImages;
+#else
+  mImages = true;
+#endif
+
+  ILOG() << "LevelAtlas::LoadCache(" << theFilename << ") Loaded " << mNumPages
+    << " cached atlas pages" << std::endl;
+
+  return true;
+}
+
+bool LevelAtlas::SaveCache(const std::string theFilename, GQE::Uint32 theKey) const
+{
+  std::ofstream anFile(theFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(anFile.is_open() == false)
+  {
+    return false;
+  }
+
+  AtlasHeader anHeader;
+  anHeader.magic = MAGIC;
+  anHeader.version = VERSION;
+  anHeader.key = theKey;
+  anHeader.pages = mNumPages;
+  anHeader.count = (GQE::Uint32)mPlacements.size();
+  anFile.write((const char*)&anHeader, sizeof(AtlasHeader));
+  if(mPlacements.empty() == false)
+  {
+    anFile.write((const char*)&mPlacements[0], mPlacements.size() * sizeof(Placement));
+  }
+
+  // Return true if everything was written
+  return anFile.fail() == false;
+}
+
+std::string LevelAtlas::GetPageFilename(const std::string theFilename,
+    GQE::Uint32 theIndex)
+{
+  std::ostringstream anResult;
+  anResult << theFilename << theIndex << ".png";
+  return anResult.str();
+}
+
+GQE::Uint32 LevelAtlas::HashFile(const std::string theFilename, GQE::Uint32 theHash)
+{
+  std::ifstream anFile(theFilename.c_str(), std::ios::in | std::ios::binary);
+
+  // Hash the filename too so missing files still change the key
+  for(size_t i = 0; i < theFilename.size(); i++)
+  {
+    theHash = (theHash ^ (GQE::Uint8)theFilename[i]) * 16777619U;
+  }
+
+  char anBuffer[4096];
+  while(anFile.good())
+  {
+    anFile.read(anBuffer, sizeof(anBuffer));
+    std::streamsize anCount = anFile.gcount();
+    for(std::streamsize i = 0; i < anCount; i++)
+    {
+      theHash = (theHash ^ (GQE::Uint8)anBuffer[i]) * 16777619U;
+    }
+  }
+
+  return theHash;
+}
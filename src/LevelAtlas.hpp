@@ -0,0 +1,221 @@
+/**
+ * Provides the LevelAtlas class which packs every tileset image of a level
+ * into a few atlas textures so the tiles of a screen share their textures.
+ *
+ * @file src/LevelAtlas.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Apply tileset colour keys and find opaque tiles
+ * @date 20261016 - Validate every cached placement against its page
+ */
+#ifndef LEVEL_ATLAS_HPP_INCLUDED
+#define LEVEL_ATLAS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include <GQE/Core/Core_types.hpp>
+
+/// Provides the tileset atlas class
+class LevelAtlas
+{
+  public:
+#if (SFML_VERSION_MAJOR < 2)
+    /// Each atlas page is an image which is also a texture for SFML 1.6
+    typedef sf::Image typeAtlasPage;
+#else
+    /// Each atlas page is a texture for SFML 2.0
+    typedef sf::Texture typeAtlasPage;
+#endif
+
+    /// Magic value found at the start of every atlas cache file ("TNTA")
+    static const GQE::Uint32 MAGIC = 0x41544E54;
+    /// Version of the atlas cache file format, bump on every layout change
+    static const GQE::Uint32 VERSION = 3;
+    /// The largest width and height of each atlas page in pixels
+    static const GQE::Uint32 PAGE_SIZE = 2048;
+
+    /// Where a tileset image was placed in the atlas
+    struct Placement {
+      GQE::Uint32 page;        ///< Which atlas page holds the tileset image
+      GQE::Uint32 x;           ///< Left edge of the tileset image on the page
+      GQE::Uint32 y;           ///< Top edge of the tileset image on the page
+      GQE::Uint32 width;       ///< Width of the tileset image in pixels
+      GQE::Uint32 height;      ///< Height of the tileset image in pixels
+    };
+
+    /**
+     * LevelAtlas default constructor
+     */
+    LevelAtlas();
+
+    /**
+     * LevelAtlas deconstructor
+     */
+    ~LevelAtlas();
+
+    /**
+     * Create is responsible for packing theSources tileset images provided
+     * into as few atlas pages as possible. The atlas pages are cached next
+     * to theFilename provided and are reused as long as the contents of
+     * every tileset image and colour key stay the same. The page images are
+     * kept until DropImages is called so IsOpaque can be used.
+     * @param[in] theFilename of the map the atlas is created for
+     * @param[in] theSources filenames of each tileset image in tileset order
+     * @param[in] theColorKeys of each tileset image as 0xRRGGBB or
+     *            LevelMap::NO_COLOR_KEY, pixels of this colour become transparent
+     * @return true if every tileset image was placed in the atlas
+     */
+    bool Create(const std::string theFilename,
+        const std::vector<std::string>& theSources,
+        const std::vector<GQE::Uint32>& theColorKeys);
+
+    /**
+     * GetNumPages returns the number of atlas pages
+     * @return the number of atlas pages created
+     */
+    GQE::Uint32 GetNumPages(void) const;
+
+    /**
+     * GetPage returns theIndex atlas page
+     * @param[in] theIndex of the atlas page to return
+     * @return the atlas page at theIndex
+     */
+    const typeAtlasPage& GetPage(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetPlacement returns where theTileset image was placed in the atlas
+     * @param[in] theTileset index to return the placement of
+     * @return the Placement of theTileset image
+     */
+    const Placement& GetPlacement(GQE::Uint32 theTileset) const;
+
+    /**
+     * IsOpaque returns true if every pixel of the rectangle of theTileset
+     * image provided is fully opaque. This can only be used until
+     * DropImages is called, afterwards false is always returned.
+     * @param[in] theTileset index the rectangle is in
+     * @param[in] theLeft edge of the rectangle in the tileset image
+     * @param[in] theTop edge of the rectangle in the tileset image
+     * @param[in] theWidth of the rectangle
+     * @param[in] theHeight of the rectangle
+     * @return true if the rectangle has no transparent pixels
+     */
+    bool IsOpaque(GQE::Uint32 theTileset, GQE::Uint32 theLeft, GQE::Uint32 theTop,
+        GQE::Uint32 theWidth, GQE::Uint32 theHeight) const;
+
+    /**
+     * DropImages is responsible for releasing the page images kept for
+     * IsOpaque once every tile has been loaded, the textures are kept.
+     */
+    void DropImages(void);
+
+    /**
+     * GetCacheFilename returns the atlas cache filename to use for the map
+     * theFilename provided (e.g. resources/level1.tmx becomes
+     * resources/level1.atlas).
+     * @param[in] theFilename of the map
+     * @return the atlas cache filename
+     */
+    static std::string GetCacheFilename(const std::string theFilename);
+
+  private:
+    // Variables
+    ///////////////////////////////////////////////////////////////////////////
+    /// The atlas pages or NULL if none have been created
+    typeAtlasPage*          mPages;
+    /// The number of atlas pages in mPages
+    GQE::Uint32             mNumPages;
+    /// Where each tileset image was placed, in tileset order
+    std::vector<Placement>  mPlacements;
+#if (SFML_VERSION_MAJOR >= 2)
+    /// The image of each atlas page kept for IsOpaque or NULL once dropped
+    sf::Image*              mImages;
+#else
+    /// True until DropImages is called, our pages are images already
+    bool                    mImages;
+#endif
+
+    /**
+     * LoadCache is responsible for loading the atlas pages and placements
+     * from the cache files if they were made from the same tileset images.
+     * Every placement must lie on one of the pages loaded, otherwise the
+     * cache is ignored so the atlas is made again.
+     * @param[in] theFilename of the atlas cache file
+     * @param[in] theKey computed from the contents of every tileset image
+     * @param[in] theCount of tileset images expected
+     * @return true if the cached atlas was loaded
+     */
+    bool LoadCache(const std::string theFilename, GQE::Uint32 theKey,
+        GQE::Uint32 theCount);
+
+    /**
+     * SaveCache is responsible for writing the atlas placements to the
+     * cache file, the atlas page images must already have been written.
+     * @param[in] theFilename of the atlas cache file
+     * @param[in] theKey computed from the contents of every tileset image
+     * @return true if the cache file was written
+     */
+    bool SaveCache(const std::string theFilename, GQE::Uint32 theKey) const;
+
+    /**
+     * GetPageFilename returns the image filename of theIndex atlas page
+     * @param[in] theFilename of the atlas cache file
+     * @param[in] theIndex of the atlas page
+     * @return the image filename for the atlas page
+     */
+    static std::string GetPageFilename(const std::string theFilename,
+        GQE::Uint32 theIndex);
+
+    /**
+     * HashFile is responsible for adding the contents of theFilename to
+     * theHash provided using the FNV-1a hash.
+     * @param[in] theFilename of the file to hash
+     * @param[in] theHash to add the file contents to
+     * @return the new hash value
+     */
+    static GQE::Uint32 HashFile(const std::string theFilename, GQE::Uint32 theHash);
+
+    /**
+     * LevelAtlas copy constructor is private because we do not allow copies
+     * of our atlas textures.
+     */
+    LevelAtlas(const LevelAtlas&);
+
+    /**
+     * LevelAtlas assignment operator is private because we do not allow
+     * copies of our atlas textures.
+     */
+    LevelAtlas& operator=(const LevelAtlas&);
+}; // class LevelAtlas
+#endif // LEVEL_ATLAS_HPP_INCLUDED
+
+/**
+ * @class LevelAtlas
+ * @ingroup Examples
+ * @section DESCRIPTION
+ * The LevelAtlas class packs each tileset image of a level, whole and
+ * unchanged, into one or a few atlas pages using a simple shelf packer. The
+ * sprite rect of every tile and every animation frame therefore only needs
+ * to be moved by the Placement of its tileset. The packed pages are written
+ * next to the map as PNG images along with a small cache file holding the
+ * placements and a hash of every tileset image, so later loads of the same
+ * map only read one image per page instead of one per tileset.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
@@ -0,0 +1,117 @@
+/**
+ * Provides the handling of the LevelAsset classes for the AssetManager in the
+ * GQE namespace. The AssetManager is responsible for providing the Asset
+ * management facilities for the App base class used in the GQE core library.
+ *
+ * @file src/LevelHandler.cpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Fail loads whose compiled level can't be written
+ */
+#include "LevelHandler.hpp"
+#include <GQE/Core/loggers/Log_macros.hpp>
+#include <GQE/Entity/classes/Instance.hpp>
+#include <GQE/Entity/classes/Prototype.hpp>
+
+LevelHandler::LevelHandler() :
+  GQE::TAssetHandler<LevelMap>()
+{
+  ILOG() << "LevelHandler::ctor()" << std::endl;
+}
+
+LevelHandler::~LevelHandler()
+{
+  ILOG() << "LevelHandler::dtor()" << std::endl;
+}
+
+bool LevelHandler::LoadFromFile(const GQE::typeAssetID theAssetID, LevelMap& theMap)
+{
+  // Start with a return result of false
+  bool anResult = false;
+
+  // Retrieve the filename for this asset
+  std::string anFilename = GetFilename(theAssetID);
+  // Was a valid filename found? then attempt to load the asset from anFilename
+  if(anFilename.length() > 0)
+  {
+    // Determine the compiled level filename to use for this TMX map file
+    std::string anBinaryFilename = LevelMap::GetBinaryFilename(anFilename);
+
+    // Compile the TMX map file if the compiled level is missing or outdated,
+    // never fall back to an outdated compiled level if that fails
+    const bool anStale = LevelMap::IsStale(anFilename, anBinaryFilename);
+    const bool anCompiled = anStale && LevelMap::Compile(anFilename, anBinaryFilename);
+    if(anStale == false || anCompiled)
+    {
+      // Memory map the compiled level file
+      anResult = theMap.Open(anBinaryFilename);
+
+      // A compiled level written by an older version fails validation,
+      // compile it once more and try again
+      if(anResult == false && anCompiled == false && anFilename != anBinaryFilename)
+      {
+        ILOG() << "LevelHandler::LoadFromFile(" << theAssetID
+          << ") Compiling " << anFilename << " again" << std::endl;
+        anResult = LevelMap::Compile(anFilename, anBinaryFilename) &&
+          theMap.Open(anBinaryFilename);
+      }
+
+      if(anResult == false)
+      {
+        ELOG() << "LevelHandler::LoadFromFile(" << theAssetID
+          << ") Unable to open compiled level " << anBinaryFilename << std::endl;
+      }
+    }
+    else
+    {
+      ELOG() << "LevelHandler::LoadFromFile(" << theAssetID
+        << ") Unable to compile " << anFilename << std::endl;
+    }
+  }
+  else
+  {
+    ELOG() << "LevelHandler::LoadFromFile(" << theAssetID
+      << ") No filename provided!" << std::endl;
+  }
+
+  // Return anResult of true if successful, false otherwise
+  return anResult;
+}
+
+bool LevelHandler::LoadFromMemory(const GQE::typeAssetID theAssetID,LevelMap& theMap)
+{
+  // Compiled levels are memory mapped from their file, see LoadFromFile
+  ELOG() << "LevelHandler::LoadFromMemory(" << theAssetID
+    << ") Levels can only be loaded from a file!" << std::endl;
+
+  // Return false, nothing was loaded
+  return false;
+}
+
+bool LevelHandler::LoadFromNetwork(const GQE::typeAssetID theAssetID, LevelMap& theMap)
+{
+  // Compiled levels are memory mapped from their file, see LoadFromFile
+  ELOG() << "LevelHandler::LoadFromNetwork(" << theAssetID
+    << ") Levels can only be loaded from a file!" << std::endl;
+
+  // Return false, nothing was loaded
+  return false;
+}
+/**
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
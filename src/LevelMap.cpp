@@ -0,0 +1,828 @@
+/**
+ * Provides the LevelMap class which represents a compiled binary version of a
+ * TMX map file that can be memory mapped and used without any XML parsing.
+ *
+ * @file src/LevelMap.cpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Store identical property sets only once
+ * @date 20261016 - Write compiled levels to a temporary file first
+ */
+#include "LevelMap.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+// windows.h renames GetObject which is used by LevelMap and Tmx::ObjectGroup
+#undef GetObject
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <SFML/Graphics.hpp>
+#include <GQE/Core/loggers/Log_macros.hpp>
+#include <GQE/Core/utils/StringUtil.hpp>
+#include <TmxParser/Tmx.h>
+
+/// Empty string returned for invalid string table offsets
+static const char* gEmptyString = "";
+
+LevelMap::LevelMap() :
+  mData(NULL),
+  mSize(0),
+  mHeader(NULL)
+{
+}
+
+LevelMap::~LevelMap()
+{
+  // Unmap the file if it is still mapped
+  Close();
+}
+
+bool LevelMap::Open(const std::string theFilename)
+{
+  // Close any previously mapped file first
+  Close();
+
+#if defined(_WIN32)
+  // Open the file for reading
+  HANDLE anFile = CreateFileA(theFilename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(anFile != INVALID_HANDLE_VALUE)
+  {
+    LARGE_INTEGER anSize;
+    if(GetFileSizeEx(anFile, &anSize) && anSize.QuadPart >= (LONGLONG)sizeof(Header))
+    {
+      // Create a read only mapping for the entire file
+      HANDLE anMapping = CreateFileMappingA(anFile, NULL, PAGE_READONLY, 0, 0, NULL);
+      if(anMapping != NULL)
+      {
+        mData = (const char*)MapViewOfFile(anMapping, FILE_MAP_READ, 0, 0, 0);
+        mSize = (size_t)anSize.QuadPart;
+
+        // The view keeps the mapping alive, we don't need the handle anymore
+        CloseHandle(anMapping);
+      }
+    }
+
+    // The mapping keeps the file open, we don't need the handle anymore
+    CloseHandle(anFile);
+  }
+#else
+  // Open the file for reading
+  int anFile = open(theFilename.c_str(), O_RDONLY);
+  if(anFile >= 0)
+  {
+    struct stat anStat;
+    if(fstat(anFile, &anStat) == 0 && anStat.st_size >= (off_t)sizeof(Header))
+    {
+      // Map the entire file as read only
+      void* anData = mmap(NULL, (size_t)anStat.st_size, PROT_READ, MAP_PRIVATE, anFile, 0);
+      if(anData != MAP_FAILED)
+      {
+        mData = (const char*)anData;
+        mSize = (size_t)anStat.st_size;
+      }
+    }
+
+    // The mapping keeps the file open, we don't need the descriptor anymore
+    close(anFile);
+  }
+#endif
+
+  // Did we map the file? then validate its contents before using it
+  if(mData != NULL)
+  {
+    mHeader = (const Header*)mData;
+    if(Validate() == false)
+    {
+      ELOG() << "LevelMap::Open(" << theFilename
+        << ") Invalid or out of date compiled level file!" << std::endl;
+
+      // Don't keep invalid files mapped
+      Close();
+    }
+  }
+  else
+  {
+    ELOG() << "LevelMap::Open(" << theFilename
+      << ") Unable to map compiled level file!" << std::endl;
+  }
+
+  // Return true if we have a valid file mapped
+  return IsOpen();
+}
+
+void LevelMap::Close(void)
+{
+  if(mData != NULL)
+  {
+#if defined(_WIN32)
+    UnmapViewOfFile(mData);
+#else
+    munmap((void*)mData, mSize);
+#endif
+  }
+
+  // Don't keep addresses we have unmapped around
+  mData = NULL;
+  mSize = 0;
+  mHeader = NULL;
+}
+
+bool LevelMap::IsOpen(void) const
+{
+  return mHeader != NULL;
+}
+
+GQE::Uint32 LevelMap::GetWidth(void) const
+{
+  return mHeader->width;
+}
+
+GQE::Uint32 LevelMap::GetHeight(void) const
+{
+  return mHeader->height;
+}
+
+GQE::Uint32 LevelMap::GetTileWidth(void) const
+{
+  return mHeader->tileWidth;
+}
+
+GQE::Uint32 LevelMap::GetTileHeight(void) const
+{
+  return mHeader->tileHeight;
+}
+
+LevelMap::Range LevelMap::GetProperties(void) const
+{
+  return mHeader->properties;
+}
+
+const LevelMap::Property& LevelMap::GetProperty(GQE::Uint32 theIndex) const
+{
+  return ((const Property*)(mData + mHeader->propertySet.offset))[theIndex];
+}
+
+GQE::Uint32 LevelMap::GetNumTilesets(void) const
+{
+  return mHeader->tilesets.count;
+}
+
+const LevelMap::Tileset& LevelMap::GetTileset(GQE::Uint32 theIndex) const
+{
+  return ((const Tileset*)(mData + mHeader->tilesets.offset))[theIndex];
+}
+
+GQE::Uint32 LevelMap::GetNumTileTypes(void) const
+{
+  return mHeader->tileTypes.count;
+}
+
+const LevelMap::TileType& LevelMap::GetTileType(GQE::Uint32 theIndex) const
+{
+  return ((const TileType*)(mData + mHeader->tileTypes.offset))[theIndex];
+}
+
+GQE::Uint32 LevelMap::GetNumLayers(void) const
+{
+  return mHeader->layers.count;
+}
+
+const LevelMap::Layer& LevelMap::GetLayer(GQE::Uint32 theIndex) const
+{
+  return ((const Layer*)(mData + mHeader->layers.offset))[theIndex];
+}
+
+const GQE::Uint16* LevelMap::GetCells(GQE::Uint32 theIndex) const
+{
+  return (const GQE::Uint16*)(mData + GetLayer(theIndex).cells);
+}
+
+GQE::Uint32 LevelMap::GetNumObjects(void) const
+{
+  return mHeader->objects.count;
+}
+
+const LevelMap::Object& LevelMap::GetObject(GQE::Uint32 theIndex) const
+{
+  return ((const Object*)(mData + mHeader->objects.offset))[theIndex];
+}
+
+const char* LevelMap::GetString(GQE::Uint32 theOffset) const
+{
+  // Validate has already made sure the string table ends with a terminator
+  if(theOffset < mHeader->strings.count)
+  {
+    return mData + mHeader->strings.offset + theOffset;
+  }
+
+  // Return an empty string for invalid offsets
+  return gEmptyString;
+}
+
+bool LevelMap::Validate(void) const
+{
+  // Start by checking the header values themselves
+  if(mHeader->magic != MAGIC || mHeader->version != VERSION ||
+     mHeader->size != mSize || mHeader->width == 0 || mHeader->height == 0)
+  {
+    return false;
+  }
+
+  // Make sure each table lies within the mapped file
+  const Table* anTables[] = {
+    &mHeader->tilesets, &mHeader->tileTypes, &mHeader->layers,
+    &mHeader->objects, &mHeader->propertySet, &mHeader->strings };
+  const size_t anSizes[] = {
+    sizeof(Tileset), sizeof(TileType), sizeof(Layer),
+    sizeof(Object), sizeof(Property), sizeof(char) };
+  for(size_t i = 0; i < sizeof(anSizes) / sizeof(anSizes[0]); i++)
+  {
+    if(anTables[i]->offset > mSize ||
+       (mSize - anTables[i]->offset) / anSizes[i] < anTables[i]->count)
+    {
+      return false;
+    }
+  }
+
+  // The string table must end with a null terminator
+  if(mHeader->strings.count == 0 ||
+     mData[mHeader->strings.offset + mHeader->strings.count - 1] != '\0')
+  {
+    return false;
+  }
+
+  // Make sure each layer has all of its cells within the mapped file
+  const size_t anCellSize = (size_t)mHeader->width * mHeader->height * sizeof(GQE::Uint16);
+  for(GQE::Uint32 i = 0; i < mHeader->layers.count; i++)
+  {
+    const Layer& anLayer = GetLayer(i);
+    if((anLayer.cells % sizeof(GQE::Uint16)) != 0 ||
+       anLayer.cells > mSize || mSize - anLayer.cells < anCellSize)
+    {
+      return false;
+    }
+
+    // Every non empty cell must refer to a valid TileType
+    const GQE::Uint16* anCells = GetCells(i);
+    for(size_t j = 0; j < (size_t)mHeader->width * mHeader->height; j++)
+    {
+      if(anCells[j] > mHeader->tileTypes.count)
+      {
+        return false;
+      }
+    }
+  }
+
+  // Every TileType must refer to a valid Tileset and valid properties
+  for(GQE::Uint32 i = 0; i < mHeader->tileTypes.count; i++)
+  {
+    if(GetTileType(i).tileset >= mHeader->tilesets.count ||
+       IsValidRange(GetTileType(i).properties) == false)
+    {
+      return false;
+    }
+  }
+
+  // Every other property range must lie within the property table
+  bool anValid = IsValidRange(mHeader->properties);
+  for(GQE::Uint32 i = 0; anValid && i < mHeader->layers.count; i++)
+  {
+    anValid = IsValidRange(GetLayer(i).properties);
+  }
+  for(GQE::Uint32 i = 0; anValid && i < mHeader->objects.count; i++)
+  {
+    anValid = IsValidRange(GetObject(i).properties);
+  }
+  if(anValid == false)
+  {
+    return false;
+  }
+
+  // Everything checks out
+  return true;
+}
+
+bool LevelMap::IsValidRange(const Range& theRange) const
+{
+  return theRange.first <= mHeader->propertySet.count &&
+    mHeader->propertySet.count - theRange.first >= theRange.count;
+}
+
+std::string LevelMap::GetBinaryFilename(const std::string theFilename)
+{
+  // Find the extension which must come after the last path separator
+  std::string::size_type anSlash = theFilename.find_last_of("/\\");
+  std::string::size_type anDot = theFilename.find_last_of('.');
+
+  // Strip the extension if one was found
+  std::string anResult(theFilename);
+  if(anDot != std::string::npos && (anSlash == std::string::npos || anDot > anSlash))
+  {
+    anResult.erase(anDot);
+  }
+
+  // Add our compiled level extension
+  anResult.append(".tmb");
+
+  return anResult;
+}
+
+bool LevelMap::IsStale(const std::string theFilename,
+    const std::string theBinaryFilename)
+{
+  struct stat anSource;
+  struct stat anBinary;
+
+  // Missing compiled level files are always stale
+  if(stat(theBinaryFilename.c_str(), &anBinary) != 0)
+  {
+    return true;
+  }
+
+  // Without a TMX map file the compiled level is all we have
+  if(theFilename == theBinaryFilename || stat(theFilename.c_str(), &anSource) != 0)
+  {
+    return false;
+  }
+
+  // Stale if the TMX map file was saved after the compiled level was written
+  return anSource.st_mtime > anBinary.st_mtime;
+}
+
+/// Helper class used by Compile to collect each table before writing them
+class LevelMapWriter
+{
+  public:
+    std::vector<LevelMap::Tileset>  mTilesets;
+    std::vector<LevelMap::TileType> mTileTypes;
+    std::vector<LevelMap::Layer>    mLayers;
+    std::vector<LevelMap::Object>   mObjects;
+    std::vector<LevelMap::Property> mProperties;
+    std::vector<GQE::Uint16>        mCells;
+    std::vector<char>               mStrings;
+    std::map<std::string, GQE::Uint32> mStringOffsets;
+    std::map<std::string, LevelMap::Range> mPropertySets;
+
+    LevelMapWriter()
+    {
+      // Offset 0 is always the empty string
+      AddString("");
+    }
+
+    GQE::Uint32 AddString(const std::string theString)
+    {
+      // Reuse identical strings already in the string table
+      std::map<std::string, GQE::Uint32>::iterator anIter = mStringOffsets.find(theString);
+      if(anIter != mStringOffsets.end())
+      {
+        return anIter->second;
+      }
+
+      // Append the new string and its terminator
+      GQE::Uint32 anOffset = (GQE::Uint32)mStrings.size();
+      mStrings.insert(mStrings.end(), theString.begin(), theString.end());
+      mStrings.push_back('\0');
+      mStringOffsets[theString] = anOffset;
+
+      return anOffset;
+    }
+
+    LevelMap::Range AddProperties(const std::map<std::string, std::string>& theProperties)
+    {
+      LevelMap::Range anRange;
+      anRange.first = 0;
+      anRange.count = 0;
+
+      // Every empty property set is the same empty range
+      if(theProperties.empty())
+      {
+        return anRange;
+      }
+
+      // Identical property sets (e.g. every coin of a treasure tileset) are
+      // parsed once and share the same range
+      std::string anKey;
+      std::map<std::string, std::string>::const_iterator anIter = theProperties.begin();
+      while(anIter != theProperties.end())
+      {
+        anKey.append(anIter->first);
+        anKey.push_back('\0');
+        anKey.append(anIter->second);
+        anKey.push_back('\0');
+        anIter++;
+      }
+      std::map<std::string, LevelMap::Range>::iterator anSet = mPropertySets.find(anKey);
+      if(anSet != mPropertySets.end())
+      {
+        return anSet->second;
+      }
+
+      anRange.first = (GQE::Uint32)mProperties.size();
+      anIter = theProperties.begin();
+      while(anIter != theProperties.end())
+      {
+        // Skip properties without a name, they can't be typed
+        if(anIter->first.empty() == false)
+        {
+          mProperties.push_back(ParseProperty(anIter->first, anIter->second));
+          anRange.count++;
+        }
+
+        // Iterate to the next property
+        anIter++;
+      }
+      mPropertySets[anKey] = anRange;
+
+      return anRange;
+    }
+
+    LevelMap::Property ParseProperty(const std::string theName, const std::string theValue)
+    {
+      LevelMap::Property anProperty;
+      std::memset(&anProperty, 0, sizeof(anProperty));
+      anProperty.name = AddString(theName);
+
+      // The first letter of the property name determines its type
+      switch(theName.at(0))
+      {
+        case 'b':
+        case 'B':
+          anProperty.type = LevelMap::PropertyBool;
+          anProperty.value.u[0] = GQE::ParseBool(theValue, false) ? 1 : 0;
+          break;
+        case 'c':
+        case 'C':
+          {
+            sf::Color anColor = GQE::ParseColor(theValue, sf::Color(0,0,0,0));
+            anProperty.type = LevelMap::PropertyColor;
+            anProperty.value.u[0] = anColor.r;
+            anProperty.value.u[1] = anColor.g;
+            anProperty.value.u[2] = anColor.b;
+            anProperty.value.u[3] = anColor.a;
+          }
+          break;
+        case 'f':
+        case 'F':
+          anProperty.type = LevelMap::PropertyFloat;
+          anProperty.value.f[0] = GQE::ParseFloat(theValue, 0.0f);
+          break;
+        case 'i':
+        case 'I':
+          anProperty.type = LevelMap::PropertyInt32;
+          anProperty.value.i[0] = GQE::ParseInt32(theValue, 0);
+          break;
+        case 'r':
+        case 'R':
+          {
+            sf::IntRect anRect = GQE::ParseIntRect(theValue, sf::IntRect(0,0,0,0));
+            anProperty.type = LevelMap::PropertyIntRect;
+#if (SFML_VERSION_MAJOR < 2)
+            anProperty.value.i[0] = anRect.Left;
+            anProperty.value.i[1] = anRect.Top;
+            anProperty.value.i[2] = anRect.GetWidth();
+            anProperty.value.i[3] = anRect.GetHeight();
+#else
+            anProperty.value.i[0] = anRect.left;
+            anProperty.value.i[1] = anRect.top;
+            anProperty.value.i[2] = anRect.width;
+            anProperty.value.i[3] = anRect.height;
+#endif
+          }
+          break;
+        case 'u':
+        case 'U':
+          anProperty.type = LevelMap::PropertyUint32;
+          anProperty.value.u[0] = GQE::ParseUint32(theValue, 0);
+          break;
+        case 'v':
+        case 'V':
+          {
+            sf::Vector2f anVector = GQE::ParseVector2f(theValue, sf::Vector2f(0.0f,0.0f));
+            anProperty.type = LevelMap::PropertyVector2f;
+            anProperty.value.f[0] = anVector.x;
+            anProperty.value.f[1] = anVector.y;
+          }
+          break;
+        case 'w':
+        case 'W':
+          {
+            sf::Vector2u anVector = GQE::ParseVector2u(theValue, sf::Vector2u(0,0));
+            anProperty.type = LevelMap::PropertyVector2u;
+            anProperty.value.u[0] = anVector.x;
+            anProperty.value.u[1] = anVector.y;
+          }
+          break;
+        case 'z':
+        case 'Z':
+          {
+            sf::Vector3f anVector = GQE::ParseVector3f(theValue, sf::Vector3f(0.0f,0.0f,0.0f));
+            anProperty.type = LevelMap::PropertyVector3f;
+            anProperty.value.f[0] = anVector.x;
+            anProperty.value.f[1] = anVector.y;
+            anProperty.value.f[2] = anVector.z;
+          }
+          break;
+        default:
+          anProperty.type = LevelMap::PropertyString;
+          anProperty.value.u[0] = AddString(theValue);
+          break;
+      }
+
+      return anProperty;
+    }
+};
+
+/// Helper used by Compile to round theOffset up to the next 4 byte boundary
+static GQE::Uint32 AlignOffset(size_t theOffset)
+{
+  return (GQE::Uint32)((theOffset + 3) & ~(size_t)3);
+}
+
+/// Helper used by Compile to write theSize bytes of theData at theOffset in theFile
+static void WriteTable(std::ofstream& theFile, GQE::Uint32 theOffset,
+    const void* theData, size_t theSize)
+{
+  // Pad up to the start of this table
+  while((GQE::Uint32)theFile.tellp() < theOffset)
+  {
+    theFile.put('\0');
+  }
+
+  if(theSize > 0)
+  {
+    theFile.write((const char*)theData, (std::streamsize)theSize);
+  }
+}
+
+bool LevelMap::Compile(const std::string theFilename,
+    const std::string theBinaryFilename)
+{
+  // Parse the TMX map file, this is the slow step we are trying to avoid
+  Tmx::Map anMap;
+  anMap.ParseFile(theFilename);
+  if(anMap.HasError() || anMap.GetWidth() <= 0 || anMap.GetHeight() <= 0)
+  {
+    ELOG() << "LevelMap::Compile(" << theFilename
+      << ") Error parsing TMX map file, error code: " << anMap.GetErrorCode() << std::endl;
+    return false;
+  }
+
+  // Collect each table here before writing them out below
+  LevelMapWriter anWriter;
+  Header anHeader;
+  std::memset(&anHeader, 0, sizeof(anHeader));
+  anHeader.magic = MAGIC;
+  anHeader.version = VERSION;
+  anHeader.width = (GQE::Uint32)anMap.GetWidth();
+  anHeader.height = (GQE::Uint32)anMap.GetHeight();
+  anHeader.tileWidth = (GQE::Uint32)anMap.GetTileWidth();
+  anHeader.tileHeight = (GQE::Uint32)anMap.GetTileHeight();
+  anHeader.properties = anWriter.AddProperties(anMap.GetProperties().GetList());
+
+  // Tilesets
+  for(int i = 0; i < anMap.GetNumTilesets(); i++)
+  {
+    const Tmx::Tileset* anTileset = anMap.GetTileset(i);
+    const Tmx::Image* anImage = anTileset->GetImage();
+    Tileset anRecord;
+    anRecord.name = anWriter.AddString(anTileset->GetName());
+    anRecord.source = anWriter.AddString(anImage->GetSource());
+    anRecord.firstGid = (GQE::Uint32)anTileset->GetFirstGid();
+    anRecord.tileWidth = (GQE::Uint32)anTileset->GetTileWidth();
+    anRecord.tileHeight = (GQE::Uint32)anTileset->GetTileHeight();
+    anRecord.imageWidth = (GQE::Uint32)anImage->GetWidth();
+    anRecord.imageHeight = (GQE::Uint32)anImage->GetHeight();
+    anRecord.transparent = NO_COLOR_KEY;
+    if(anImage->GetTransparentColor().empty() == false)
+    {
+      anRecord.transparent = (GQE::Uint32)strtoul(
+        anImage->GetTransparentColor().c_str(), NULL, 16) & 0x00FFFFFF;
+    }
+
+    // Older TMX files don't provide the image size, get it from the image itself
+    if(anRecord.imageWidth == 0 || anRecord.imageHeight == 0)
+    {
+      sf::Image anPixels;
+      std::string anSource("resources/");
+      anSource.append(anImage->GetSource());
+#if (SFML_VERSION_MAJOR < 2)
+      if(anPixels.LoadFromFile(anSource))
+      {
+        anRecord.imageWidth = anPixels.GetWidth();
+        anRecord.imageHeight = anPixels.GetHeight();
+      }
+#else
+      if(anPixels.loadFromFile(anSource))
+      {
+        anRecord.imageWidth = anPixels.getSize().x;
+        anRecord.imageHeight = anPixels.getSize().y;
+      }
+#endif
+    }
+    anWriter.mTilesets.push_back(anRecord);
+  }
+
+  // Tile layers, each distinct tile becomes a single TileType record
+  std::map<std::pair<int, int>, GQE::Uint16> anTileTypes;
+  for(int i = 0; i < anMap.GetNumLayers(); i++)
+  {
+    const Tmx::Layer* anLayer = anMap.GetLayer(i);
+    Layer anRecord;
+    anRecord.name = anWriter.AddString(anLayer->GetName());
+    anRecord.properties = anWriter.AddProperties(anLayer->GetProperties().GetList());
+    anRecord.cells = (GQE::Uint32)anWriter.mCells.size(); // Fixed up below
+    anWriter.mLayers.push_back(anRecord);
+
+    for(int y = 0; y < anMap.GetHeight(); y++)
+    {
+      for(int x = 0; x < anMap.GetWidth(); x++)
+      {
+        const Tmx::MapTile anMapTile = anLayer->GetTile(x, y);
+        GQE::Uint16 anCell = 0;
+
+        // If tilesetId is not >= 0 then it is an empty tile
+        if(anMapTile.tilesetId >= 0)
+        {
+          std::pair<int, int> anKey(anMapTile.tilesetId, (int)anMapTile.id);
+          std::map<std::pair<int, int>, GQE::Uint16>::iterator anIter = anTileTypes.find(anKey);
+          if(anIter != anTileTypes.end())
+          {
+            anCell = anIter->second;
+          }
+          else if(anWriter.mTileTypes.size() < 0xFFFF)
+          {
+            const Tileset& anTileset = anWriter.mTilesets[anMapTile.tilesetId];
+            const GQE::Uint32 anColumns = anTileset.tileWidth > 0 ?
+              anTileset.imageWidth / anTileset.tileWidth : 0;
+            TileType anType;
+            anType.tileset = (GQE::Uint32)anMapTile.tilesetId;
+            anType.id = (GQE::Uint32)anMapTile.id;
+            anType.rect[0] = anColumns > 0 ? (GQE::Int32)((anType.id % anColumns) * anTileset.tileWidth) : 0;
+            anType.rect[1] = anColumns > 0 ? (GQE::Int32)((anType.id / anColumns) * anTileset.tileHeight) : 0;
+            anType.rect[2] = (GQE::Int32)anTileset.tileWidth;
+            anType.rect[3] = (GQE::Int32)anTileset.tileHeight;
+            anType.properties.first = 0;
+            anType.properties.count = 0;
+
+            // Tmx::Tile type for the given Map Tile ID value
+            const Tmx::Tile* anTile = anMap.GetTileset(anMapTile.tilesetId)->GetTile(anMapTile.id);
+            if(anTile != NULL)
+            {
+              anType.properties = anWriter.AddProperties(anTile->GetProperties().GetList());
+            }
+
+            anWriter.mTileTypes.push_back(anType);
+            anCell = (GQE::Uint16)anWriter.mTileTypes.size();
+            anTileTypes[anKey] = anCell;
+          }
+          else
+          {
+            ELOG() << "LevelMap::Compile(" << theFilename
+              << ") Too many distinct tiles, ignoring tile at ("
+              << x << ", " << y << ")" << std::endl;
+          }
+        }
+
+        anWriter.mCells.push_back(anCell);
+      } // for(int x = 0; x < anMap.GetWidth(); x++)
+    } // for(int y = 0; y < anMap.GetHeight(); y++)
+  } // for(int i = 0; i < anMap.GetNumLayers(); i++)
+
+  // Objects from every object group are flattened into one table
+  for(int i = 0; i < anMap.GetNumObjectGroups(); i++)
+  {
+    const Tmx::ObjectGroup* anObjectGroup = anMap.GetObjectGroup(i);
+    for(int j = 0; j < anObjectGroup->GetNumObjects(); j++)
+    {
+      const Tmx::Object* anObject = anObjectGroup->GetObject(j);
+      Object anRecord;
+      anRecord.name = anWriter.AddString(anObject->GetName());
+      anRecord.type = anWriter.AddString(anObject->GetType());
+      anRecord.group = anWriter.AddString(anObjectGroup->GetName());
+      anRecord.x = anObject->GetX();
+      anRecord.y = anObject->GetY();
+      anRecord.width = anObject->GetWidth();
+      anRecord.height = anObject->GetHeight();
+      anRecord.properties = anWriter.AddProperties(anObject->GetProperties().GetList());
+      anWriter.mObjects.push_back(anRecord);
+    }
+  }
+
+  // Now lay out each table one after another on 4 byte boundaries
+  size_t anOffset = sizeof(Header);
+  anHeader.tilesets.offset = AlignOffset(anOffset);
+  anHeader.tilesets.count = (GQE::Uint32)anWriter.mTilesets.size();
+  anOffset = anHeader.tilesets.offset + anWriter.mTilesets.size() * sizeof(Tileset);
+  anHeader.tileTypes.offset = AlignOffset(anOffset);
+  anHeader.tileTypes.count = (GQE::Uint32)anWriter.mTileTypes.size();
+  anOffset = anHeader.tileTypes.offset + anWriter.mTileTypes.size() * sizeof(TileType);
+  anHeader.layers.offset = AlignOffset(anOffset);
+  anHeader.layers.count = (GQE::Uint32)anWriter.mLayers.size();
+  anOffset = anHeader.layers.offset + anWriter.mLayers.size() * sizeof(Layer);
+  anHeader.objects.offset = AlignOffset(anOffset);
+  anHeader.objects.count = (GQE::Uint32)anWriter.mObjects.size();
+  anOffset = anHeader.objects.offset + anWriter.mObjects.size() * sizeof(Object);
+  anHeader.propertySet.offset = AlignOffset(anOffset);
+  anHeader.propertySet.count = (GQE::Uint32)anWriter.mProperties.size();
+  anOffset = anHeader.propertySet.offset + anWriter.mProperties.size() * sizeof(Property);
+  const GQE::Uint32 anCellsOffset = AlignOffset(anOffset);
+  anOffset = anCellsOffset + anWriter.mCells.size() * sizeof(GQE::Uint16);
+  anHeader.strings.offset = AlignOffset(anOffset);
+  anHeader.strings.count = (GQE::Uint32)anWriter.mStrings.size();
+  anHeader.size = anHeader.strings.offset + anHeader.strings.count;
+
+  // Fix up each layer cell index into a file offset
+  for(size_t i = 0; i < anWriter.mLayers.size(); i++)
+  {
+    anWriter.mLayers[i].cells = anCellsOffset +
+      anWriter.mLayers[i].cells * (GQE::Uint32)sizeof(GQE::Uint16);
+  }
+
+  // Write everything out to a temporary file first so a failed write never
+  // leaves a partial compiled level file behind
+  const std::string anTempFilename = theBinaryFilename + ".tmp";
+  std::ofstream anFile(anTempFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(anFile.is_open() == false)
+  {
+    ELOG() << "LevelMap::Compile(" << theFilename << ") Unable to create "
+      << anTempFilename << std::endl;
+    return false;
+  }
+  anFile.write((const char*)&anHeader, sizeof(Header));
+  WriteTable(anFile, anHeader.tilesets.offset, anWriter.mTilesets.empty() ? NULL :
+    &anWriter.mTilesets[0], anWriter.mTilesets.size() * sizeof(Tileset));
+  WriteTable(anFile, anHeader.tileTypes.offset, anWriter.mTileTypes.empty() ? NULL :
+    &anWriter.mTileTypes[0], anWriter.mTileTypes.size() * sizeof(TileType));
+  WriteTable(anFile, anHeader.layers.offset, anWriter.mLayers.empty() ? NULL :
+    &anWriter.mLayers[0], anWriter.mLayers.size() * sizeof(Layer));
+  WriteTable(anFile, anHeader.objects.offset, anWriter.mObjects.empty() ? NULL :
+    &anWriter.mObjects[0], anWriter.mObjects.size() * sizeof(Object));
+  WriteTable(anFile, anHeader.propertySet.offset, anWriter.mProperties.empty() ? NULL :
+    &anWriter.mProperties[0], anWriter.mProperties.size() * sizeof(Property));
+  WriteTable(anFile, anCellsOffset, anWriter.mCells.empty() ? NULL :
+    &anWriter.mCells[0], anWriter.mCells.size() * sizeof(GQE::Uint16));
+  WriteTable(anFile, anHeader.strings.offset,
+    &anWriter.mStrings[0], anWriter.mStrings.size());
+  anFile.close();
+
+  // Replace the compiled level file only if everything was written
+  bool anResult = anFile.fail() == false;
+  if(anResult)
+  {
+#if defined(_WIN32)
+    anResult = MoveFileExA(anTempFilename.c_str(), theBinaryFilename.c_str(),
+      MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    anResult = std::rename(anTempFilename.c_str(), theBinaryFilename.c_str()) == 0;
+#endif
+  }
+
+  if(anResult)
+  {
+    ILOG() << "LevelMap::Compile(" << theFilename << ") wrote " << theBinaryFilename
+      << " (" << anHeader.size << " bytes, " << anHeader.tileTypes.count
+      << " tile types)" << std::endl;
+  }
+  else
+  {
+    ELOG() << "LevelMap::Compile(" << theFilename << ") Unable to write "
+      << theBinaryFilename << std::endl;
+
+    // Don't leave the partial temporary file behind
+    std::remove(anTempFilename.c_str());
+  }
+
+  // Return true if everything was written
+  return anResult;
+}
+
+/**
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
@@ -0,0 +1,352 @@
+/**
+ * Provides the LevelMap class which represents a compiled binary version of a
+ * TMX map file that can be memory mapped and used without any XML parsing.
+ *
+ * @file src/LevelMap.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Store identical property sets only once
+ */
+#ifndef LEVEL_MAP_HPP_INCLUDED
+#define LEVEL_MAP_HPP_INCLUDED
+
+#include <string>
+#include <GQE/Core/Core_types.hpp>
+
+/// Provides the compiled binary level map class
+class LevelMap
+{
+  public:
+    /// Magic value found at the start of every compiled level file ("TNTM")
+    static const GQE::Uint32 MAGIC = 0x4D544E54;
+    /// Version of the compiled level file format, bump on every layout change
+    static const GQE::Uint32 VERSION = 1;
+    /// Value used for Tileset::transparent when no colour key was provided
+    static const GQE::Uint32 NO_COLOR_KEY = 0xFFFFFFFF;
+
+    /// Property value types, selected by the first letter of the property name
+    enum PropertyType {
+      PropertyString   = 0, ///< Any other letter is a std::string
+      PropertyBool     = 1, ///< b or B is a boolean
+      PropertyColor    = 2, ///< c or C is a sf::Color
+      PropertyFloat    = 3, ///< f or F is a float
+      PropertyInt32    = 4, ///< i or I is a GQE::Int32
+      PropertyIntRect  = 5, ///< r or R is a sf::IntRect
+      PropertyUint32   = 6, ///< u or U is a GQE::Uint32
+      PropertyVector2f = 7, ///< v or V is a sf::Vector2f
+      PropertyVector2u = 8, ///< w or W is a sf::Vector2u
+      PropertyVector3f = 9  ///< z or Z is a sf::Vector3f
+    };
+
+    /// A range of records in one of the tables below
+    struct Range {
+      GQE::Uint32 first;  ///< Index of the first record
+      GQE::Uint32 count;  ///< Number of records
+    };
+
+    /// A table of fixed size records somewhere in the file
+    struct Table {
+      GQE::Uint32 offset; ///< Offset in bytes from the start of the file
+      GQE::Uint32 count;  ///< Number of records (or bytes for the string table)
+    };
+
+    /// Header found at the start of every compiled level file
+    struct Header {
+      GQE::Uint32 magic;       ///< Must be MAGIC
+      GQE::Uint32 version;     ///< Must be VERSION
+      GQE::Uint32 size;        ///< Total size of the file in bytes
+      GQE::Uint32 width;       ///< Map width in tiles
+      GQE::Uint32 height;      ///< Map height in tiles
+      GQE::Uint32 tileWidth;   ///< Map tile width in pixels
+      GQE::Uint32 tileHeight;  ///< Map tile height in pixels
+      Range       properties;  ///< Map wide properties
+      Table       tilesets;    ///< Table of Tileset records
+      Table       tileTypes;   ///< Table of TileType records
+      Table       layers;      ///< Table of Layer records
+      Table       objects;     ///< Table of Object records
+      Table       propertySet; ///< Table of Property records
+      Table       strings;     ///< Table of null terminated strings
+    };
+
+    /// A pre-parsed property, see PropertyType for the value layout
+    struct Property {
+      GQE::Uint32 name;        ///< String table offset of the property name
+      GQE::Uint32 type;        ///< PropertyType of this property
+      union {
+        GQE::Uint32 u[4];      ///< bool, sf::Color (r,g,b,a), Uint32, Vector2u and string offset
+        GQE::Int32  i[4];      ///< Int32 and IntRect (left, top, width, height)
+        float       f[4];      ///< float, Vector2f and Vector3f
+      } value;
+    };
+
+    /// A tileset image used by the map
+    struct Tileset {
+      GQE::Uint32 name;        ///< String table offset of the tileset name
+      GQE::Uint32 source;      ///< String table offset of the image filename
+      GQE::Uint32 firstGid;    ///< First global tile ID of this tileset
+      GQE::Uint32 tileWidth;   ///< Tile width in pixels
+      GQE::Uint32 tileHeight;  ///< Tile height in pixels
+      GQE::Uint32 imageWidth;  ///< Image width in pixels
+      GQE::Uint32 imageHeight; ///< Image height in pixels
+      GQE::Uint32 transparent; ///< Colour key as 0xRRGGBB or NO_COLOR_KEY
+    };
+
+    /// A distinct tile used by one or more map cells
+    struct TileType {
+      GQE::Uint32 tileset;     ///< Index of the Tileset this tile comes from
+      GQE::Uint32 id;          ///< Tile ID within its Tileset
+      GQE::Int32  rect[4];     ///< Sprite rect (left, top, width, height) in the Tileset image
+      Range       properties;  ///< Tile specific properties
+    };
+
+    /// A tile layer of the map
+    struct Layer {
+      GQE::Uint32 name;        ///< String table offset of the layer name
+      Range       properties;  ///< Layer wide properties
+      GQE::Uint32 cells;       ///< Offset of width*height Uint16 cells (TileType index+1, 0=empty)
+    };
+
+    /// An object from one of the object groups of the map
+    struct Object {
+      GQE::Uint32 name;        ///< String table offset of the object name
+      GQE::Uint32 type;        ///< String table offset of the object type
+      GQE::Uint32 group;       ///< String table offset of the object group name
+      GQE::Int32  x;           ///< Position in pixels
+      GQE::Int32  y;           ///< Position in pixels
+      GQE::Int32  width;       ///< Size in pixels
+      GQE::Int32  height;      ///< Size in pixels
+      Range       properties;  ///< Object specific properties
+    };
+
+    /**
+     * LevelMap default constructor
+     */
+    LevelMap();
+
+    /**
+     * LevelMap deconstructor will unmap any file still open
+     */
+    virtual ~LevelMap();
+
+    /**
+     * Open will memory map theFilename provided and validate its contents.
+     * Any previously opened file will be closed first.
+     * @param[in] theFilename of the compiled level to open
+     * @return true if the file was mapped and is a valid compiled level
+     */
+    bool Open(const std::string theFilename);
+
+    /**
+     * Close will unmap the currently opened file, if any.
+     */
+    void Close(void);
+
+    /**
+     * IsOpen will return true if a valid compiled level is currently mapped.
+     * @return true if a compiled level is mapped, false otherwise
+     */
+    bool IsOpen(void) const;
+
+    /**
+     * GetWidth returns the map width in tiles
+     * @return the width of the map in tiles
+     */
+    GQE::Uint32 GetWidth(void) const;
+
+    /**
+     * GetHeight returns the map height in tiles
+     * @return the height of the map in tiles
+     */
+    GQE::Uint32 GetHeight(void) const;
+
+    /**
+     * GetTileWidth returns the map tile width in pixels
+     * @return the width of each tile in pixels
+     */
+    GQE::Uint32 GetTileWidth(void) const;
+
+    /**
+     * GetTileHeight returns the map tile height in pixels
+     * @return the height of each tile in pixels
+     */
+    GQE::Uint32 GetTileHeight(void) const;
+
+    /**
+     * GetProperties returns the range of map wide properties
+     * @return the Range of map wide properties
+     */
+    Range GetProperties(void) const;
+
+    /**
+     * GetProperty returns theIndex Property record
+     * @param[in] theIndex of the Property record to return
+     * @return the Property record at theIndex
+     */
+    const Property& GetProperty(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetNumTilesets returns the number of tilesets in the map
+     * @return the number of Tileset records
+     */
+    GQE::Uint32 GetNumTilesets(void) const;
+
+    /**
+     * GetTileset returns theIndex Tileset record
+     * @param[in] theIndex of the Tileset record to return
+     * @return the Tileset record at theIndex
+     */
+    const Tileset& GetTileset(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetNumTileTypes returns the number of distinct tiles used by the map
+     * @return the number of TileType records
+     */
+    GQE::Uint32 GetNumTileTypes(void) const;
+
+    /**
+     * GetTileType returns theIndex TileType record
+     * @param[in] theIndex of the TileType record to return
+     * @return the TileType record at theIndex
+     */
+    const TileType& GetTileType(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetNumLayers returns the number of tile layers in the map
+     * @return the number of Layer records
+     */
+    GQE::Uint32 GetNumLayers(void) const;
+
+    /**
+     * GetLayer returns theIndex Layer record
+     * @param[in] theIndex of the Layer record to return
+     * @return the Layer record at theIndex
+     */
+    const Layer& GetLayer(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetCells returns the packed cells of theIndex layer which are stored
+     * row by row (y * width + x) as TileType index + 1 or 0 for empty cells.
+     * @param[in] theIndex of the Layer to return the cells for
+     * @return pointer to the first of width*height cells
+     */
+    const GQE::Uint16* GetCells(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetNumObjects returns the number of objects in all object groups
+     * @return the number of Object records
+     */
+    GQE::Uint32 GetNumObjects(void) const;
+
+    /**
+     * GetObject returns theIndex Object record
+     * @param[in] theIndex of the Object record to return
+     * @return the Object record at theIndex
+     */
+    const Object& GetObject(GQE::Uint32 theIndex) const;
+
+    /**
+     * GetString returns the null terminated string at theOffset provided
+     * @param[in] theOffset into the string table
+     * @return the string at theOffset or an empty string if invalid
+     */
+    const char* GetString(GQE::Uint32 theOffset) const;
+
+    /**
+     * GetBinaryFilename returns the compiled level filename to use for the
+     * TMX filename provided (e.g. resources/Level0.tmx -> resources/Level0.tmb)
+     * @param[in] theFilename of the TMX map file
+     * @return the filename of the compiled level file
+     */
+    static std::string GetBinaryFilename(const std::string theFilename);
+
+    /**
+     * IsStale returns true if theBinaryFilename is missing or older than
+     * theFilename TMX map file it was compiled from.
+     * @param[in] theFilename of the TMX map file
+     * @param[in] theBinaryFilename of the compiled level file
+     * @return true if theBinaryFilename should be compiled again
+     */
+    static bool IsStale(const std::string theFilename,
+        const std::string theBinaryFilename);
+
+    /**
+     * Compile will parse theFilename TMX map file and write the compiled
+     * level to theBinaryFilename provided. This is the only place XML, base64
+     * and zlib decoding of the map takes place.
+     * @param[in] theFilename of the TMX map file to compile
+     * @param[in] theBinaryFilename of the compiled level file to write
+     * @return true if the compiled level file was written successfully
+     */
+    static bool Compile(const std::string theFilename,
+        const std::string theBinaryFilename);
+
+  private:
+    // Variables
+    ///////////////////////////////////////////////////////////////////////////
+    /// The start of the memory mapped file or NULL if nothing is mapped
+    const char*   mData;
+    /// The size in bytes of the memory mapped file
+    size_t        mSize;
+    /// The header at the start of mData
+    const Header* mHeader;
+
+    /**
+     * Validate is responsible for making sure every table and layer found in
+     * the header lies within the memory mapped file.
+     * @return true if the mapped file is a valid compiled level
+     */
+    bool Validate(void) const;
+
+    /**
+     * IsValidRange is responsible for making sure theRange of properties
+     * provided lies within the property table of the mapped file.
+     * @param[in] theRange of properties to check
+     * @return true if theRange is within the property table
+     */
+    bool IsValidRange(const Range& theRange) const;
+
+    /**
+     * LevelMap copy constructor is private because we do not allow copies of
+     * our memory mapped file.
+     */
+    LevelMap(const LevelMap&);
+
+    /**
+     * LevelMap assignment operator is private because we do not allow copies
+     * of our memory mapped file.
+     */
+    LevelMap& operator=(const LevelMap&);
+}; // class LevelMap
+#endif // LEVEL_MAP_HPP_INCLUDED
+
+/**
+ * @class LevelMap
+ * @ingroup Examples
+ * @section DESCRIPTION
+ * The LevelMap class provides read only access to a compiled level file. A
+ * compiled level holds the packed tile cells of every layer, the distinct
+ * tile types used by those cells with their sprite rects already resolved,
+ * and every map, layer, tile and object property already parsed into its
+ * final type. The file is memory mapped so opening a level costs no parsing
+ * at all; the TMX map file is only read by Compile when the compiled level is
+ * missing or older than the TMX map file. Identical property sets are only
+ * stored once, so tiles and layers sharing the same properties also share
+ * the same property Range.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
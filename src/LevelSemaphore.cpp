@@ -0,0 +1,153 @@
+/**
+ * Provides the LevelSemaphore class which lets the movement worker threads
+ * of LevelSystem sleep until there is work for them.
+ *
+ * @file src/LevelSemaphore.cpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Size the movement worker pool from the processor count
+ */
+#include "LevelSemaphore.hpp"
+#include <climits>
+#include <new>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <GQE/Core/loggers/Log_macros.hpp>
+
+#if !defined(_WIN32)
+/// The pthread values behind each LevelSemaphore
+struct PosixSemaphore {
+  pthread_mutex_t mutex;     ///< Protects count
+  pthread_cond_t  condition; ///< Signaled every time count is incremented
+  unsigned int    count;     ///< The current count
+};
+#endif
+
+LevelSemaphore::LevelSemaphore() :
+  mHandle(NULL)
+{
+#if defined(_WIN32)
+  mHandle = CreateSemaphoreA(NULL, 0, LONG_MAX, NULL);
+#else
+  PosixSemaphore* anSemaphore = new(std::nothrow) PosixSemaphore;
+  if(anSemaphore != NULL)
+  {
+    pthread_mutex_init(&anSemaphore->mutex, NULL);
+    pthread_cond_init(&anSemaphore->condition, NULL);
+    anSemaphore->count = 0;
+  }
+  mHandle = anSemaphore;
+#endif
+
+  if(mHandle == NULL)
+  {
+    ELOG() << "LevelSemaphore::ctor() Unable to create semaphore!" << std::endl;
+  }
+}
+
+LevelSemaphore::~LevelSemaphore()
+{
+  if(mHandle != NULL)
+  {
+#if defined(_WIN32)
+    CloseHandle((HANDLE)mHandle);
+#else
+    PosixSemaphore* anSemaphore = static_cast<PosixSemaphore*>(mHandle);
+    pthread_cond_destroy(&anSemaphore->condition);
+    pthread_mutex_destroy(&anSemaphore->mutex);
+    delete anSemaphore;
+#endif
+  }
+
+  // Don't keep semaphores we have destroyed around
+  mHandle = NULL;
+}
+
+void LevelSemaphore::Wait(void)
+{
+  if(mHandle != NULL)
+  {
+#if defined(_WIN32)
+    WaitForSingleObject((HANDLE)mHandle, INFINITE);
+#else
+    PosixSemaphore* anSemaphore = static_cast<PosixSemaphore*>(mHandle);
+    pthread_mutex_lock(&anSemaphore->mutex);
+    while(anSemaphore->count == 0)
+    {
+      pthread_cond_wait(&anSemaphore->condition, &anSemaphore->mutex);
+    }
+    anSemaphore->count--;
+    pthread_mutex_unlock(&anSemaphore->mutex);
+#endif
+  }
+}
+
+void LevelSemaphore::Post(void)
+{
+  if(mHandle != NULL)
+  {
+#if defined(_WIN32)
+    ReleaseSemaphore((HANDLE)mHandle, 1, NULL);
+#else
+    PosixSemaphore* anSemaphore = static_cast<PosixSemaphore*>(mHandle);
+    pthread_mutex_lock(&anSemaphore->mutex);
+    anSemaphore->count++;
+    pthread_cond_signal(&anSemaphore->condition);
+    pthread_mutex_unlock(&anSemaphore->mutex);
+#endif
+  }
+}
+
+bool LevelSemaphore::IsValid(void) const
+{
+  return mHandle != NULL;
+}
+
+unsigned int LevelSemaphore::GetProcessorCount(void)
+{
+  // Assume a single processor if the platform can't tell us
+  unsigned int anResult = 1;
+
+#if defined(_WIN32)
+  SYSTEM_INFO anInfo;
+  GetSystemInfo(&anInfo);
+  if(anInfo.dwNumberOfProcessors > 0)
+  {
+    anResult = (unsigned int)anInfo.dwNumberOfProcessors;
+  }
+#else
+  const long anCount = sysconf(_SC_NPROCESSORS_ONLN);
+  if(anCount > 0)
+  {
+    anResult = (unsigned int)anCount;
+  }
+#endif
+
+  // Return the number of processors online
+  return anResult;
+}
+
+/**
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
@@ -0,0 +1,99 @@
+/**
+ * Provides the LevelSemaphore class which lets the movement worker threads
+ * of LevelSystem sleep until there is work for them.
+ *
+ * @file src/LevelSemaphore.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ * @date 20261016 - Size the movement worker pool from the processor count
+ */
+#ifndef LEVEL_SEMAPHORE_HPP_INCLUDED
+#define LEVEL_SEMAPHORE_HPP_INCLUDED
+
+/// Provides the counting semaphore class
+class LevelSemaphore
+{
+  public:
+    /**
+     * LevelSemaphore default constructor, starts with a count of 0
+     */
+    LevelSemaphore();
+
+    /**
+     * LevelSemaphore deconstructor
+     */
+    ~LevelSemaphore();
+
+    /**
+     * Wait is responsible for blocking the calling thread until the count
+     * is above 0 and then decrementing it.
+     */
+    void Wait(void);
+
+    /**
+     * Post is responsible for incrementing the count, waking up one thread
+     * blocked in Wait if there is one.
+     */
+    void Post(void);
+
+    /**
+     * IsValid will return true if the platform semaphore was created.
+     * @return true if Wait and Post can be used, false otherwise
+     */
+    bool IsValid(void) const;
+
+    /**
+     * GetProcessorCount returns the number of processors online, which is
+     * used to decide how many worker threads are worth starting.
+     * @return the number of processors online, at least 1
+     */
+    static unsigned int GetProcessorCount(void);
+
+  private:
+    // Variables
+    ///////////////////////////////////////////////////////////////////////////
+    /// The platform semaphore created by the constructor
+    void*         mHandle;
+
+    /**
+     * LevelSemaphore copy constructor is private because we do not allow
+     * copies of our semaphore.
+     */
+    LevelSemaphore(const LevelSemaphore&);
+
+    /**
+     * LevelSemaphore assignment operator is private because we do not allow
+     * copies of our semaphore.
+     */
+    LevelSemaphore& operator=(const LevelSemaphore&);
+}; // class LevelSemaphore
+#endif // LEVEL_SEMAPHORE_HPP_INCLUDED
+
+/**
+ * @class LevelSemaphore
+ * @ingroup Examples
+ * @section DESCRIPTION
+ * The LevelSemaphore class is a counting semaphore. SFML provides threads
+ * and mutexes but nothing a thread can sleep on until another thread hands
+ * it work, so the movement worker threads of LevelSystem wait on one of
+ * these between movement phases instead of being created for every phase.
+ * A Windows semaphore is used on Windows, a pthread mutex and condition
+ * variable everywhere else.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
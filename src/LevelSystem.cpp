@@ -9,7 +9,32 @@
  * @date 20120730 - Improved network synchronization for multiplayer game play
  * @date 20120731 - Add sound effects and player spawn points
  * @date 20120910 - Fix SFML v1.6 issues
+ * @date 20261016 - Load levels from compiled level files
+ * @date 20261016 - Load levels using a background loader thread
+ * @date 20261016 - Store tiles as packed cells with a shared tile type table
+ * @date 20261016 - Cache the typed tile properties of each property set pair
+ * @date 20261016 - Allocate each level from a LevelArena and unload it for real
+ * @date 20261016 - Draw tiles from a tileset atlas built at load time
+ * @date 20261016 - Draw each layer of the current screen with vertex arrays
+ * @date 20261016 - Bake the static layers of each screen into render textures
+ * @date 20261016 - Cache the score label of each player
+ * @date 20261016 - Interpolate player positions between fixed updates
+ * @date 20261016 - Check walls against a wall bitmap of the whole map
+ * @date 20261016 - Index treasures by cell and keep a collected bitset
+ * @date 20261016 - Sweep the bounding box through the wall bitmap
+ * @date 20261016 - Run movement and collision on arrays gathered once per tick
+ * @date 20261016 - Run the movement of each screen on a pool of worker threads
+ * @date 20261016 - Use cached property handles instead of string lookups
+ * @date 20261016 - Keep a dense array of registered IEntity classes
+ * @date 20261016 - Reserve the tile types of a level before loading its tiles
+ * @date 20261016 - Animate every tile type of a map without screen registrations
+ * @date 20261016 - Skip tiles hidden under opaque tiles of higher layers
+ * @date 20261016 - Save and restore game tick state for rollback
+ * @date 20261016 - Only load a new map once every game tick is confirmed
  */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include "LevelSystem.hpp"
 #include <SFML/Graphics.hpp>
 #include <GQE/Entity/systems/RenderSystem.hpp>
@@ -22,13 +47,12 @@ LevelSystem::LevelSystem(GQE::IApp& theApp,
     const GQE::typeAssetID theLoadingFilename,
     const GQE::typeAssetID theFontFilename,
     GQE::Uint32 theScreenTileWidth,
-    GQE::Uint32 theScreenTileHeight,
-    GQE::Uint32 theLoaderCount):
+    GQE::Uint32 theScreenTileHeight):
   ISystem("LevelSystem",theApp),
   mAnimationSystem(theAnimationSystem),
   mTile("map_tile"),
   mObject("map_object"),
-  mTilesets(NULL),
+  mAtlas(NULL),
   mSounds(NULL),
   mScreenTileWidth(theScreenTileWidth),
   mScreenTileHeight(theScreenTileHeight),
@@ -40,8 +64,21 @@ LevelSystem::LevelSystem(GQE::IApp& theApp,
   mMapFilename(theMapFilename),
   mLoadingFilename(theLoadingFilename),
   mScreen(0,0),
+  mWorkersQuit(false),
+  mMovementPhase(MovementCollect),
+  mNumMovementTasks(0),
+  mNextTask(0),
   mLoader(NULL),
-  mLoaderCount(theLoaderCount)
+  mScreens(NULL),
+  mWalls(NULL),
+  mCollected(NULL),
+  mNumTreasures(0),
+  mMapLoads(0),
+  mReplaying(false)
+#if (SFML_VERSION_MAJOR >= 2)
+  , mBatchesDirty(false),
+  mBaked(NULL)
+#endif
 {
 #if (SFML_VERSION_MAJOR < 2)
   // First load our Arial font
@@ -49,6 +86,12 @@ LevelSystem::LevelSystem(GQE::IApp& theApp,
 #else
   // First load our Arial font
   mFont.loadFromFile(theFontFilename);
+
+  // Rasterize the digits used by every score label once
+  for(unsigned int anDigit = 0; anDigit < 10; anDigit++)
+  {
+    mDigits[anDigit] = mFont.getGlyph('0' + anDigit, SCORE_SIZE, false);
+  }
 #endif
 
   // Create our array of sound effects and load them in now
@@ -114,17 +157,63 @@ LevelSystem::LevelSystem(GQE::IApp& theApp,
 
 LevelSystem::~LevelSystem()
 {
+  // Stop any level load still in progress before anything it uses goes away
+  if(mLoader != NULL)
+  {
+    if(mLoader->thread != NULL)
+    {
+      {
+        // Ask the loader thread to stop at the next step
+        sf::Lock anLock(mLoader->mutex);
+        mLoader->cancel = true;
+      }
+
+#if (SFML_VERSION_MAJOR < 2)
+      mLoader->thread->Wait();
+#else
+      mLoader->thread->wait();
+#endif
+      delete mLoader->thread;
+    }
+
+    // Delete the atlas that was never handed over to mAtlas
+    delete mLoader->atlas;
+
+    // Delete the tile types that were never published
+    DropTileTypes(mLoader->tileTypes);
+
+    // Delete the loader context
+    delete mLoader;
+
+    // Don't keep addresses we have deleted around
+    mLoader = NULL;
+  }
+
   // This will cause all screens to be dropped, essentially unloading the map
-  //DropAllScreens();
+  DropAllScreens();
 
   // Delete the sound effects
   delete[] mSounds;
 
-  // Delete the current tilesets
-  delete[] mTilesets;
+  // Delete the current tileset atlas
+  delete mAtlas;
+
+  // Don't keep atlas pointers around
+  mAtlas = NULL;
 
-  // Don't keep tileset pointers around
-  mTilesets = NULL;
+  // Wake up our movement worker threads one last time so they return
+  mWorkersQuit = true;
+  for(size_t anIndex = 0; anIndex < mWorkers.size(); anIndex++)
+  {
+    mWorkStart.Post();
+  }
+
+  // Delete our movement worker threads, which waits for each one to return
+  for(size_t anIndex = 0; anIndex < mWorkers.size(); anIndex++)
+  {
+    delete mWorkers[anIndex];
+  }
+  mWorkers.clear();
 }
 
 void LevelSystem::AddProperties(GQE::IEntity* theEntity)
@@ -132,10 +221,6 @@ void LevelSystem::AddProperties(GQE::IEntity* theEntity)
   theEntity->mProperties.Add<GQE::typeAssetID>("sMapFilename", mMapFilename);
   theEntity->mProperties.Add<GQE::typeAssetID>("sLoadingFilename", mLoadingFilename);
   theEntity->mProperties.Add<sf::Vector2u>("wMap", sf::Vector2u(0,0));
-  theEntity->mProperties.Add<sf::Vector2u>("wMapU", sf::Vector2u(0,0));
-  theEntity->mProperties.Add<sf::Vector2u>("wMapL", sf::Vector2u(0,0));
-  theEntity->mProperties.Add<sf::Vector2u>("wMapD", sf::Vector2u(0,0));
-  theEntity->mProperties.Add<sf::Vector2u>("wMapR", sf::Vector2u(0,0));
   theEntity->mProperties.Add<sf::Vector2u>("wScreen", sf::Vector2u(0,0));
   theEntity->mProperties.Add<sf::Vector2u>("wScreenPrevious", sf::Vector2u(0,0));
   theEntity->mProperties.Add<sf::Sprite>("Sprite", sf::Sprite());
@@ -164,64 +249,247 @@ void LevelSystem::HandleEvents(sf::Event theEvent)
 
 void LevelSystem::UpdateFixed()
 {
-  // Are we not loading a map now? then see if we need to load one now
-  if(mLoader == NULL)
+  // Are we loading a map now? every IEntity is moved by UpdateMovement
+  // which the NetworkSystem calls once for each game tick
+  if(mLoader != NULL)
   {
-    // Search through each z-order map to find theEntityID provided
-    std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+    // Has the loader thread finished with stages 1 through 3 yet?
+    bool anDone = false;
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      sf::Lock anLock(mLoader->mutex);
+      anDone = mLoader->done;
+    }
+
+    // Only touch mLoader once the loader thread is done with it
+    if(anDone)
+    {
+      // Have the screens loaded by the loader thread been published yet?
+      if(mLoader->thread != NULL)
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
+        LoadPublish();
+      }
+      else if(mLoader->stage == WaitingStage)
+      {
+        LoadStage4();
+      }
+      else
+      {
+        LoadStage5();
+      }
+    }
+  }
+}
 
-        // Increment the IEntity iterator second
-        anQueue++;
+void LevelSystem::UpdateMovement(bool theReplay)
+{
+  // Are we not loading a map now? then move every IEntity
+  if(mLoader == NULL)
+  {
+    mReplaying = theReplay;
 
-        // Calculate new MapX and MapY values for this Entity
-        UpdateCoordinates(anEntity);
+    // Copy the movement values of every IEntity into our arrays, one
+    // task per screen since players on different screens never interact
+    GatherMovement();
 
-        // Check for treasures in our current location first
-        CheckTreasure(anEntity);
+    // Calculate map coordinates, pick up treasures and cross screen edges
+    RunMovement(MovementCollect);
+    MergeMovement(MovementCollect);
 
-        // Check screen edges before we check for walls
-        CheckScreenEdges(anEntity);
+    // Check for walls against every IEntity
+    RunMovement(MovementWalls);
+    MergeMovement(MovementWalls);
 
-        // Check for walls against this IEntity class
-        CheckWalls(anEntity);
+    // Write the movement values back to every IEntity
+    ScatterMovement();
 
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
-        {
-          // Retrieve the LevelSystem properties from this IEntity
-          GQE::typeAssetID anMapFilename = anEntity->mProperties.Get<GQE::typeAssetID>("sMapFilename");
-          GQE::typeAssetID anLoadingFilename = anEntity->mProperties.Get<GQE::typeAssetID>("sLoadingFilename");
+    mReplaying = false;
+  }
+}
 
-          // Does the Filename not match the LevelFilename value, then transition to new map
-          if(anMapFilename != mMapFilename)
-          {
-            // Load the new map
-            LoadMap(anMapFilename, anLoadingFilename);
-          }
+void LevelSystem::SaveState(LevelState& theState)
+{
+  // Copy the collected bitset of the current map
+  theState.map = mMapLoads;
+  theState.collected.clear();
+  if(mCollected != NULL)
+  {
+    theState.collected.assign(mCollected, mCollected + (mNumTreasures + 31) / 32);
+  }
+
+  // Copy the movement values of every registered IEntity
+  theState.entity.clear();
+  theState.position.clear();
+  theState.screen.clear();
+  theState.score.clear();
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    PlayerProperties& anProperties = *mPlayers[anIndex];
+    theState.entity.push_back(anProperties.entity->GetID());
+    theState.position.push_back(anProperties.position.Get());
+    theState.screen.push_back(anProperties.screen.Get());
+    theState.score.push_back(anProperties.score.Get());
+  }
+}
+
+bool LevelSystem::RestoreState(const LevelState& theState)
+{
+  // Never restore a state saved for another map or while loading one
+  if(mLoader != NULL || theState.map != mMapLoads ||
+      theState.collected.size() != (mCollected != NULL ? (mNumTreasures + 31) / 32 : 0))
+  {
+    return false;
+  }
+
+  // Put back every treasure whose collected bit differs from theState
+  const GQE::Uint32 anScreenTiles = mScreenTileWidth * mScreenTileHeight;
+  for(GQE::Uint32 anScreen = 0; anScreen < mScreenWidth * mScreenHeight; anScreen++)
+  {
+    ScreenInfo& anInfo = mScreens[anScreen];
+    for(GQE::Uint32 anIndex = 0; anIndex < anInfo.numTreasures; anIndex++)
+    {
+      const GQE::Uint32 anTreasure = anInfo.firstTreasure + anIndex;
+      const GQE::Uint32 anBit = 1U << (anTreasure % 32);
+      const bool anCollected = (theState.collected[anTreasure / 32] & anBit) != 0;
+      if(anCollected != ((mCollected[anTreasure / 32] & anBit) != 0))
+      {
+        const TileRef& anRef = anInfo.treasures[anIndex];
+        TileCell& anCell = anInfo.cells[anRef.layer * anScreenTiles + anRef.cell];
+        if(anCollected)
+        {
+          anCell.flags &= ~TILE_VISIBLE;
         }
         else
         {
-          // Network players should disappear if they are not on the same screen as local players
-          sf::Vector2u anScreen = anEntity->mProperties.Get<sf::Vector2u>("wScreen");
-          anEntity->mProperties.Set<bool>("bVisible", (anScreen == mScreen));
+          anCell.flags |= TILE_VISIBLE;
         }
-      } // while(anQueue != anIter->second.end())
 
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
+        // A treasure that is also a wall opens or closes its cell
+        if(anCell.flags & TILE_WALL)
+        {
+          UpdateWall(sf::Vector2u(
+            (anScreen % mScreenWidth) * mScreenTileWidth + anRef.cell % mScreenTileWidth,
+            (anScreen / mScreenWidth) * mScreenTileHeight + anRef.cell / mScreenTileWidth));
+        }
+#if (SFML_VERSION_MAJOR >= 2)
+
+        // The treasure is part of our batches if it is on the current screen
+        mBatchesDirty = mBatchesDirty || (anScreen == mScreen.x + mScreen.y * mScreenWidth);
+#endif
+      }
+    } // for(GQE::Uint32 anIndex = 0; anIndex < anInfo.numTreasures; anIndex++)
+  } // for(GQE::Uint32 anScreen = 0; anScreen < mScreenWidth * mScreenHeight; anScreen++)
+  if(!theState.collected.empty())
+  {
+    std::copy(theState.collected.begin(), theState.collected.end(), mCollected);
+  }
+
+  // Put every registered IEntity back where it was
+  for(size_t anIndex = 0; anIndex < theState.entity.size(); anIndex++)
+  {
+    std::map<const GQE::typeEntityID, PlayerProperties>::iterator anIter =
+      mPlayerProperties.find(theState.entity[anIndex]);
+    if(anIter != mPlayerProperties.end())
+    {
+      anIter->second.position.Set(theState.position[anIndex]);
+      anIter->second.screen.Set(theState.screen[anIndex]);
+      anIter->second.score.Set(theState.score[anIndex]);
+    }
+  }
+
+  // Return true, theState was restored
+  return true;
+}
+
+void LevelSystem::FinishReplay(void)
+{
+  // Are we not loading a map now? then follow the local player
+  if(mLoader == NULL)
+  {
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    {
+      PlayerProperties& anProperties = *mPlayers[anIndex];
+      if(anProperties.local.Get() && anProperties.screen.Get() != mScreen)
+      {
+        SwitchScreen(anProperties.screen.Get());
+      }
+    }
+
+    // Network players should disappear if they are not on the same screen as local players
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    {
+      PlayerProperties& anProperties = *mPlayers[anIndex];
+      if(anProperties.local.Get() == false)
+      {
+        anProperties.visible.Set(anProperties.screen.Get() == mScreen);
+      }
+    }
+  }
+}
+
+void LevelSystem::UpdateRenderStates(void)
+{
+  // Are we not loading a map now? then look for players that have moved
+  if(mLoader == NULL)
+  {
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    {
+      PlayerProperties& anProperties = *mPlayers[anIndex];
+      UpdateRenderState(anProperties.entity, anProperties.position.Get(),
+        anProperties.screen.Get());
+    }
+  }
+}
+
+bool LevelSystem::IsMapPending(void) const
+{
+  // Assume no local player asked for a new map
+  bool anResult = false;
+
+  // Are we not loading a map now? then look for a local player on another map
+  if(mLoader == NULL)
+  {
+    for(size_t anIndex = 0; anIndex < mPlayers.size() && anResult == false; anIndex++)
+    {
+      const PlayerProperties& anProperties = *mPlayers[anIndex];
+      anResult = anProperties.local.Get() &&
+        anProperties.mapFilename.Get() != mMapFilename;
+    }
   }
+
+  // Return anResult of true if a new map is waiting to be loaded
+  return anResult;
+}
+
+void LevelSystem::LoadPendingMap(void)
+{
+  // Are we not loading a map now? then look for a local player on another map
+  for(size_t anIndex = 0; anIndex < mPlayers.size() && mLoader == NULL; anIndex++)
+  {
+    // Retrieve the LevelSystem properties from this IEntity
+    PlayerProperties& anProperties = *mPlayers[anIndex];
+    GQE::typeAssetID anMapFilename = anProperties.mapFilename.Get();
+    GQE::typeAssetID anLoadingFilename = anProperties.loadingFilename.Get();
+
+    // Does the Filename not match the LevelFilename value, then transition to new map
+    if(anProperties.local.Get() && anMapFilename != mMapFilename)
+    {
+      // Load the new map
+      LoadMap(anMapFilename, anLoadingFilename);
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size() && mLoader == NULL; anIndex++)
 }
 
 void LevelSystem::UpdateVariable(float theElaspedTime)
 {
+  // Advance the interpolation of each registered IEntity
+  std::map<const GQE::typeEntityID, RenderState>::iterator anIter = mRenderStates.begin();
+  while(anIter != mRenderStates.end())
+  {
+    anIter->second.elapsed += theElaspedTime;
+
+    // Increment render state iterator
+    anIter++;
+  }
 }
 
 void LevelSystem::Draw()
@@ -229,34 +497,9 @@ void LevelSystem::Draw()
   // Are we suppose to be loading a map now? Then call the correct stage
   if(mLoader != NULL)
   {
-    // Draw the loading please wait screen and percent complete bar
+    // Draw the loading please wait screen and percent complete bar, the
+    // loader thread and UpdateFixed take care of the loading itself
     DrawBar();
-
-    // One call to each stage is too slow, give each stage several runs
-    for(unsigned int i=0; mLoader && i < mLoaderCount; i++)
-    {
-      switch(mLoader->stage)
-      {
-        case TilesetStage:
-          LoadStage1();
-          break;
-        case TileStage:
-          LoadStage2();
-          break;
-        case ObjectStage:
-          LoadStage3();
-          break;
-        case WaitingStage:
-          LoadStage4();
-          break;
-        case UnknownStage:
-        default:
-          // Error, no such stage!?
-        case CleanupStage:
-          LoadStage5();
-          break;
-      }
-    }
   }
   else
   {
@@ -277,51 +520,42 @@ void LevelSystem::Draw()
         // Increment the IEntity iterator second
         anQueue++;
 
+        // Get the property handles of this Entity
+        PlayerProperties& anProperties = GetPlayerProperties(anEntity);
+
         // If this Entity is visible, draw the player and his/her score above him
-        if(anEntity->mProperties.Get<bool>("bVisible"))
+        if(anProperties.visible.Get())
         {
-          // Get the other pseudo RenderSystem properties now
-          sf::Vector2f anPosition = anEntity->mProperties.Get<sf::Vector2f>("vPosition");
-          sf::IntRect anBoundingBox = anEntity->mProperties.Get<sf::IntRect>("rBoundingBox");
-          sf::Sprite anSprite=anEntity->mProperties.Get<sf::Sprite>("Sprite");
+          // Get the other pseudo RenderSystem properties now, drawing
+          // between the last two simulated positions of this player
+          sf::Vector2f anPosition = GetRenderPosition(anEntity);
+          sf::IntRect anBoundingBox = anProperties.boundingBox.Get();
+          sf::Sprite anSprite = anProperties.sprite.Get();
 #if SFML_VERSION_MAJOR<2
           anSprite.SetPosition(anPosition);
-          anSprite.SetSubRect(anEntity->mProperties.Get<sf::IntRect>("rSpriteRect"));
+          anSprite.SetSubRect(anProperties.spriteRect.Get());
           mApp.mWindow.Draw(anSprite);
 #else
           anSprite.setPosition(anPosition);
-          anSprite.setTextureRect(anEntity->mProperties.Get<sf::IntRect>("rSpriteRect"));
+          anSprite.setTextureRect(anProperties.spriteRect.Get());
           mApp.mWindow.draw(anSprite);
 #endif
 
-#if (SFML_VERSION_MAJOR < 2)
-          sf::String anScore("", mFont, 16.0f);
-          // Position and color for the current players score
-          anScore.SetColor(sf::Color(255,255,255,255));
-          anScore.SetPosition(anPosition.x + anBoundingBox.Left + 6, anPosition.y - mTileHeight/3);
-#else
-          sf::Text anScore("", mFont, 16);
-          // Position and color for the current players score
-          anScore.setColor(sf::Color(255,255,255,255));
-          anScore.setPosition(anPosition.x + anBoundingBox.left + 6, anPosition.y - mTileHeight/3);
-#endif
-
-          // Create a string stream to create our percent complete string to display
-          std::ostringstream anScoreString;
-
-          // Convert score into a string so we can display it
-          anScoreString << anEntity->mProperties.Get<GQE::Uint32>("uScore");
+          // Get the cached score label, only rebuilt when uScore changes
+          ScoreLabel& anScore = GetScoreLabel(anEntity, anProperties.score.Get());
 
 #if (SFML_VERSION_MAJOR < 2)
-          // Assign our Percent Complete string value created above
-          anScore.SetText(anScoreString.str());
+          // Position for the current players score
+          anScore.text.SetPosition(anPosition.x + anBoundingBox.Left + 6, anPosition.y - mTileHeight/3);
           // Draw our score value above our player
-          mApp.mWindow.Draw(anScore);
+          mApp.mWindow.Draw(anScore.text);
 #else
-          // Assign our Percent Complete string value created above
-          anScore.setString(anScoreString.str());
+          // Position for the current players score
+          sf::RenderStates anStates(&mFont.getTexture(SCORE_SIZE));
+          anStates.transform.translate(anPosition.x + anBoundingBox.left + 6,
+            anPosition.y - mTileHeight/3);
           // Draw our score value above our player
-          mApp.mWindow.draw(anScore);
+          mApp.mWindow.draw(anScore.vertices, anStates);
 #endif
 
           /*
@@ -356,10 +590,7 @@ void LevelSystem::SwitchScreen(sf::Vector2u theScreen)
     // Make sure we are not currently loading a level
     if(mLoader == NULL)
     {
-      // First unload the current screen
-      UnloadScreen(mScreen);
-
-      // Next load the new screen
+      // Load the new screen, animated tile types stay registered
       LoadScreen(theScreen);
     }
     else
@@ -384,74 +615,49 @@ bool LevelSystem::LoadMap(const GQE::typeAssetID theMapFilename,
   // Are we starting a new map load right now? (only one at a time!)
   if(mLoader == NULL)
   {
-    // Create our Loader context which will load the map asset
+    // Create our Loader context, the map asset is loaded by the loader thread
     mLoader = new(std::nothrow) LoadContext(theMapFilename,
         theLoadingFilename);
 
-    // Make sure the initial loading and parsing of the map succeeded
-    if(mLoader != NULL &&
-        mLoader->map.HasError() == false &&
-        mLoader->map.GetNumTilesets() > 0 &&
-        mLoader->map.GetWidth() > 0 &&
-        mLoader->map.GetHeight() > 0)
+    if(mLoader != NULL)
     {
-      // Compute some total for calculating percent complete
-      mLoader->total = mLoader->map.GetNumTilesets() + 
-        mLoader->map.GetNumLayers() * mLoader->map.GetWidth() * mLoader->map.GetHeight() +
-        mLoader->map.GetNumObjectGroups() * mLoader->map.GetWidth() * mLoader->map.GetHeight() + 1;
-
-      // Allocate ImageAssets to store each tileset images
-      mLoader->tilesets = new (std::nothrow) GQE::ImageAsset[mLoader->map.GetNumTilesets()];
-
-      // Set our filenames values
+      // Set our filenames values, LoadPublish puts them back if the load fails
+      mLoader->previousMap = mMapFilename;
+      mLoader->previousLoading = mLoadingFilename;
       mMapFilename = theMapFilename;
       mLoadingFilename = theLoadingFilename;
 
-      // Search through each z-order map to loop through each registered IEntity class
-      std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-      anIter = mEntities.begin();
-      while(anIter != mEntities.end())
+      // Loop through each registered IEntity class
+      for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
       {
-        std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-        while(anQueue != anIter->second.end())
-        {
-          // Get the IEntity address first
-          GQE::IEntity* anEntity = *anQueue;
-
-          // Increment the IEntity iterator second
-          anQueue++;
-
-          // Set our bLoading property to true
-          anEntity->mProperties.Set<bool>("bLoading", true);
-
-          // Load the map properties into each registered IEntity class
-          LoadProperties(mLoader->map.GetProperties().GetList(), anEntity);
-        } // while(anQueue != anIter->second.end())
-
-        // Increment map iterator
-        anIter++;
-      } //while(anIter != mEntities.end())
-
-      // Drop all our existing screens before loading new ones below
-      //DropAllScreens();
-
-      // Calculate the number of screens
-      mScreenWidth = mLoader->map.GetWidth() / mScreenTileWidth;
-      mScreenHeight = mLoader->map.GetHeight() / mScreenTileHeight;
-      mTileWidth = (GQE::Uint32)(mTileScale.x * mLoader->map.GetTileWidth());
-      mTileHeight = (GQE::Uint32)(mTileScale.y * mLoader->map.GetTileHeight());
+        // Set our bLoading property to true
+        mPlayers[anIndex]->loading.Set(true);
+      } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 
-      // Move on to the first stage
-      mLoader->stage = TilesetStage;
+      // Create and start the loader thread which will perform stages 1 to 3
+      mLoader->thread = new(std::nothrow) sf::Thread(&LevelSystem::LoadThread, this);
+      if(mLoader->thread != NULL)
+      {
+#if (SFML_VERSION_MAJOR < 2)
+        mLoader->thread->Launch();
+#else
+        mLoader->thread->launch();
+#endif
+      }
+      else
+      {
+        // No thread available, perform stages 1 to 3 right here instead
+        LoadWorker();
+        LoadPublish();
+      }
 
-      // Now proceed with TileStage during Draw method
-      anResult = true; // Load in progress
+      // Now proceed with the remaining stages during UpdateFixed method
+      anResult = (mLoader != NULL); // Load in progress
     }
     else
     {
       ELOG() << "LevelSystem(" << theMapFilename << ", " << theLoadingFilename
-        << ") Error in parsing TmxAsset map file!"
-        << std::endl;
+        << ") Unable to create loader context!" << std::endl;
     }
   }
   else
@@ -464,399 +670,828 @@ bool LevelSystem::LoadMap(const GQE::typeAssetID theMapFilename,
   return anResult;
 }
 
-void LevelSystem::UpdateCoordinates(GQE::IEntity* theEntity)
+void LevelSystem::GatherMovement(void)
 {
-  sf::Vector2f anPosition = theEntity->mProperties.Get<sf::Vector2f>("vPosition");
-  sf::Vector2f anVelocity = theEntity->mProperties.Get<sf::Vector2f>("vVelocity");
-  sf::IntRect anBoundingBox = theEntity->mProperties.Get<sf::IntRect>("rBoundingBox");
-  sf::Vector2u anScreen = theEntity->mProperties.Get<sf::Vector2u>("wScreen");
+  MovementArrays& anMove = mMovement;
+
+  // Start over, the arrays keep their capacity from tick to tick
+  anMove.entity.clear();
+  anMove.properties.clear();
+  anMove.x.clear();
+  anMove.y.clear();
+  anMove.velocityX.clear();
+  anMove.velocityY.clear();
+  anMove.boxLeft.clear();
+  anMove.boxTop.clear();
+  anMove.boxWidth.clear();
+  anMove.boxHeight.clear();
+  anMove.screenX.clear();
+  anMove.screenY.clear();
+  anMove.score.clear();
+  anMove.visible.clear();
+  anMove.local.clear();
+  anMove.events.clear();
+
+  // Search through each z-order map to loop through each registered IEntity class
+  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
+  anIter = mEntities.begin();
+  while(anIter != mEntities.end())
+  {
+    std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
+    while(anQueue != anIter->second.end())
+    {
+      // Get the IEntity address first
+      GQE::IEntity* anEntity = *anQueue;
 
-  // Compute the center tile that we are currently on based on our current position
-#if (SFML_VERSION_MAJOR < 2)
-  GQE::Uint32 anTileCenterX = (GQE::Uint32)((anPosition.x + anBoundingBox.Left +
-    anBoundingBox.GetWidth() / 2) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileCenterY = (GQE::Uint32)((anPosition.y + anBoundingBox.Top +
-    anBoundingBox.GetHeight() / 2) / mTileHeight) % mScreenTileHeight;
-#else
-  GQE::Uint32 anTileCenterX = (GQE::Uint32)((anPosition.x + anBoundingBox.left +
-    anBoundingBox.width / 2) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileCenterY = (GQE::Uint32)((anPosition.y + anBoundingBox.top +
-    anBoundingBox.height / 2) / mTileHeight) % mScreenTileHeight;
-#endif
+      // Increment the IEntity iterator second
+      anQueue++;
 
-  // Compute the tile if moving left, right, up, or down
+      // Copy each movement property into our arrays
+      PlayerProperties& anProperties = GetPlayerProperties(anEntity);
+      const sf::Vector2f anPosition = anProperties.position.Get();
+      const sf::Vector2f anVelocity = anProperties.velocity.Get();
+      const sf::Vector2u anScreen = anProperties.screen.Get();
+      const sf::IntRect anBoundingBox = anProperties.boundingBox.Get();
+      anMove.entity.push_back(anEntity);
+      anMove.properties.push_back(&anProperties);
+      anMove.x.push_back(anPosition.x);
+      anMove.y.push_back(anPosition.y);
+      anMove.velocityX.push_back(anVelocity.x);
+      anMove.velocityY.push_back(anVelocity.y);
 #if (SFML_VERSION_MAJOR < 2)
-  GQE::Uint32 anTileLeft = (GQE::Uint32)((anPosition.x + anVelocity.x + anBoundingBox.Left) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileRight = (GQE::Uint32)((anPosition.x + anVelocity.x + anBoundingBox.Left + anBoundingBox.GetWidth()) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileUp = (GQE::Uint32)((anPosition.y + anVelocity.y + anBoundingBox.Top) / mTileHeight) % mScreenTileHeight;
-  GQE::Uint32 anTileDown = (GQE::Uint32)((anPosition.y + anVelocity.y + anBoundingBox.Top + anBoundingBox.GetHeight()) / mTileHeight) % mScreenTileHeight;
+      anMove.boxLeft.push_back((float)anBoundingBox.Left);
+      anMove.boxTop.push_back((float)anBoundingBox.Top);
+      anMove.boxWidth.push_back((float)anBoundingBox.GetWidth());
+      anMove.boxHeight.push_back((float)anBoundingBox.GetHeight());
 #else
-  GQE::Uint32 anTileLeft = (GQE::Uint32)((anPosition.x + anVelocity.x + anBoundingBox.left) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileRight = (GQE::Uint32)((anPosition.x + anVelocity.x + anBoundingBox.left + anBoundingBox.width) / mTileWidth) % mScreenTileWidth;
-  GQE::Uint32 anTileUp = (GQE::Uint32)((anPosition.y + anVelocity.y + anBoundingBox.top) / mTileHeight) % mScreenTileHeight;
-  GQE::Uint32 anTileDown = (GQE::Uint32)((anPosition.y + anVelocity.y + anBoundingBox.top + anBoundingBox.height) / mTileHeight) % mScreenTileHeight;
+      anMove.boxLeft.push_back((float)anBoundingBox.left);
+      anMove.boxTop.push_back((float)anBoundingBox.top);
+      anMove.boxWidth.push_back((float)anBoundingBox.width);
+      anMove.boxHeight.push_back((float)anBoundingBox.height);
 #endif
+      anMove.screenX.push_back(anScreen.x);
+      anMove.screenY.push_back(anScreen.y);
+      anMove.score.push_back(anProperties.score.Get());
+      anMove.visible.push_back(anProperties.visible.Get() ? 1 : 0);
+      anMove.local.push_back(anProperties.local.Get() ? 1 : 0);
+      anMove.events.push_back(0);
+    } // while(anQueue != anIter->second.end())
 
-  // Compute the map coordinates for no movement
-  theEntity->mProperties.Set<sf::Vector2u>("wMap", sf::Vector2u(
-    anTileCenterX + anScreen.x * mScreenTileWidth,
-    anTileCenterY + anScreen.y * mScreenTileHeight));
-
-  // Compute the map coordinates for up movement
-  theEntity->mProperties.Set<sf::Vector2u>("wMapU", sf::Vector2u(
-    anTileCenterX + anScreen.x * mScreenTileWidth,
-    anTileUp + anScreen.y * mScreenTileHeight));
-
-  // Compute the map coordinates for left movement
-  theEntity->mProperties.Set<sf::Vector2u>("wMapL", sf::Vector2u(
-    anTileLeft + anScreen.x * mScreenTileWidth,
-    anTileCenterY + anScreen.y * mScreenTileHeight));
+    // Increment map iterator
+    anIter++;
+  } //while(anIter != mEntities.end())
 
-  // Compute the map coordinates for down movement
-  theEntity->mProperties.Set<sf::Vector2u>("wMapD", sf::Vector2u(
-    anTileCenterX + anScreen.x * mScreenTileWidth,
-    anTileDown + anScreen.y * mScreenTileHeight));
+  // The computed values are written by UpdateCoordinates
+  const size_t anCount = anMove.entity.size();
+  anMove.mapX.resize(anCount);
+  anMove.mapY.resize(anCount);
+  anMove.tileLeft.resize(anCount);
+  anMove.tileRight.resize(anCount);
+  anMove.tileUp.resize(anCount);
+  anMove.tileDown.resize(anCount);
+
+  // Forget the screens used by the tasks of the last tick, mScreenTasks is
+  // only made again when the number of screens changes
+  const GQE::Uint32 anScreens = mScreenWidth * mScreenHeight;
+  if(mScreenTasks.size() != anScreens)
+  {
+    mScreenTasks.assign(anScreens, 0);
+  }
+  else
+  {
+    for(GQE::Uint32 anTask = 0; anTask < mNumMovementTasks; anTask++)
+    {
+      if(mMovementTasks[anTask].screen < anScreens)
+      {
+        mScreenTasks[mMovementTasks[anTask].screen] = 0;
+      }
+    }
+  }
 
-  // Compute the map coordinates for right movement
-  theEntity->mProperties.Set<sf::Vector2u>("wMapR", sf::Vector2u(
-    anTileRight + anScreen.x * mScreenTileWidth,
-    anTileCenterY + anScreen.y * mScreenTileHeight));
+  // Split every IEntity into one task per screen, keeping their z-order,
+  // the tasks keep their capacity from tick to tick as well
+  GQE::Uint32 anOutside = 0;
+  mNumMovementTasks = 0;
+  for(size_t i = 0; i < anCount; i++)
+  {
+    // Every IEntity on a screen outside of the map shares one task
+    GQE::Uint32 anScreen = anScreens;
+    if(anMove.screenX[i] < mScreenWidth && anMove.screenY[i] < mScreenHeight)
+    {
+      anScreen = anMove.screenY[i] * mScreenWidth + anMove.screenX[i];
+    }
+    GQE::Uint32& anTask = (anScreen < anScreens) ? mScreenTasks[anScreen] : anOutside;
+    if(anTask == 0)
+    {
+      if(mNumMovementTasks == mMovementTasks.size())
+      {
+        mMovementTasks.push_back(MovementTask());
+      }
+      mMovementTasks[mNumMovementTasks].entities.clear();
+      mMovementTasks[mNumMovementTasks].pickups.clear();
+      mMovementTasks[mNumMovementTasks].screen = anScreen;
+      anTask = ++mNumMovementTasks;
+    }
+    mMovementTasks[anTask - 1].entities.push_back((GQE::Uint32)i);
+  }
 }
 
-void LevelSystem::CheckTreasure(GQE::IEntity* theEntity)
+void LevelSystem::ScatterMovement(void)
 {
-  sf::Vector2u anMapCC = theEntity->mProperties.Get<sf::Vector2u>("wMap");
-  sf::Vector2u anScreen = theEntity->mProperties.Get<sf::Vector2u>("wScreen");
-  
-  // Search through each z-order map to find theEntityID provided
-  std::deque<GQE::IEntity*>::iterator anIter =
-    mScreens[anScreen.x + anScreen.y*mScreenWidth].treasures.begin();
-  while(anIter != mScreens[anScreen.x + anScreen.y*mScreenWidth].treasures.end())
+  MovementArrays& anMove = mMovement;
+  const size_t anCount = anMove.entity.size();
+  for(size_t i = 0; i < anCount; i++)
   {
-    // Get the IEntity address first
-    GQE::IEntity* anEntity = *anIter;
-
-    // Increment coin iterator
-    anIter++;
-
-    // Is this tile visible and matches our current position?
-    if(anEntity->mProperties.Get<bool>("bVisible") &&
-      anMapCC == anEntity->mProperties.Get<sf::Vector2u>("wMap"))
+    PlayerProperties& anProperties = *anMove.properties[i];
+    const sf::Vector2f anPosition(anMove.x[i], anMove.y[i]);
+    const sf::Vector2u anScreen(anMove.screenX[i], anMove.screenY[i]);
+
+    // Write each movement result back once per tick
+    anProperties.position.Set(anPosition);
+    anProperties.velocity.Set(sf::Vector2f(anMove.velocityX[i], anMove.velocityY[i]));
+    anProperties.screen.Set(anScreen);
+    anProperties.map.Set(sf::Vector2u(anMove.mapX[i], anMove.mapY[i]));
+    anProperties.score.Set(anMove.score[i]);
+
+    if(anMove.local[i] == false)
     {
-      // Get the value for this coin or treasure chest
-      GQE::Uint32 anValue = anEntity->mProperties.Get<GQE::Uint32>("uValue");
-
-      // Make the coin disappear
-      anEntity->mProperties.Set<bool>("bVisible", false);
-
-      // Add to our players total points according to the value of the treasure
-      theEntity->mProperties.Set<GQE::Uint32>("uScore",
-        theEntity->mProperties.Get<GQE::Uint32>("uScore") + anValue);
+      // Network players should disappear if they are not on the same screen as local players
+      anProperties.visible.Set(anScreen == mScreen);
+    }
+  }
+}
 
-      // If the player is visible to us, play the sound effect (if it has one)
-      if(theEntity->mProperties.Get<bool>("bVisible"))
+void LevelSystem::RunMovement(MovementPhase thePhase)
+{
+  // Let every worker know which phase to run
+  mMovementPhase = thePhase;
+  mNextTask = 0;
+
+  // Only use our worker threads if there is enough work to share
+  GQE::Uint32 anWoken = 0;
+  if(mMovement.entity.size() >= PARALLEL_ENTITIES && mNumMovementTasks > 1 &&
+      mWorkStart.IsValid() && mWorkDone.IsValid())
+  {
+    // Start our worker threads the first time they are needed, they sleep
+    // on mWorkStart between phases from then on
+    if(mWorkers.empty())
+    {
+      // The main thread takes tasks too, so leave one processor for it
+      const GQE::Uint32 anProcessors = LevelSemaphore::GetProcessorCount();
+      const GQE::Uint32 anThreads = (anProcessors - 1 < MAX_WORKER_THREADS) ?
+        anProcessors - 1 : MAX_WORKER_THREADS;
+      for(GQE::Uint32 anIndex = 0; anIndex < anThreads; anIndex++)
       {
-        // Only play if not already playing this sound effect
-#if (SFML_VERSION_MAJOR < 2)
-        if(sf::Sound::Playing != mCoin.GetStatus())
+        sf::Thread* anThread = new(std::nothrow) sf::Thread(&LevelSystem::MovementThread, this);
+        if(anThread != NULL)
         {
-          // Add sound effect for the treasure according to value
-          if(anValue < 5)
-          {
-            // Use copper coin sound
-            mCoin.SetBuffer(mSounds[0].GetAsset());
-          }
-          else if(anValue >= 5 && anValue < 10)
-          {
-            // Use silver coin sound
-            mCoin.SetBuffer(mSounds[1].GetAsset());
-          }
-          else if(anValue >= 10 && anValue < 50)
-          {
-            // Use gold coin sound
-            mCoin.SetBuffer(mSounds[2].GetAsset());
-          }
-          else if(anValue >= 50 && anValue < 100)
-          {
-            // Use treasure chest sound
-            mCoin.SetBuffer(mSounds[3].GetAsset());
-          }
-          // Now play the sound chosen above
-          mCoin.Play();
-        }
+          mWorkers.push_back(anThread);
+#if (SFML_VERSION_MAJOR < 2)
+          anThread->Launch();
 #else
-        if(sf::Sound::Playing != mCoin.getStatus())
-        {
-          // Add sound effect for the treasure according to value
-          if(anValue < 5)
-          {
-            // Use copper coin sound
-            mCoin.setBuffer(mSounds[0].GetAsset());
-          }
-          else if(anValue >= 5 && anValue < 10)
-          {
-            // Use silver coin sound
-            mCoin.setBuffer(mSounds[1].GetAsset());
-          }
-          else if(anValue >= 10 && anValue < 50)
-          {
-            // Use gold coin sound
-            mCoin.setBuffer(mSounds[2].GetAsset());
-          }
-          else if(anValue >= 50 && anValue < 100)
-          {
-            // Use treasure chest sound
-            mCoin.setBuffer(mSounds[3].GetAsset());
-          }
-          // Now play the sound chosen above
-          mCoin.play();
-        }
+          anThread->launch();
 #endif
+        }
       }
     }
-  } //while(anIter != mScreens[anScreen.x + anScreen.y*mScreenWidth].treasures.end())
-}
 
-void LevelSystem::CheckWalls(GQE::IEntity* theEntity)
-{
-  // Get the Velocity of the current player
-  sf::Vector2f anVelocity = theEntity->mProperties.Get<sf::Vector2f>("vVelocity");
+    // Wake up one worker thread less than the number of tasks
+    while(anWoken < mWorkers.size() && anWoken + 1 < mNumMovementTasks)
+    {
+      mWorkStart.Post();
+      anWoken++;
+    }
+  }
 
-  // Should we skip this check because we aren't moving?
-  if(anVelocity.x > 0.1f || anVelocity.x < -0.1f || anVelocity.y > 0.1f || anVelocity.y < -0.1f)
-  {
-    // Did we hit a wall?
-    bool anHit = false;
+  // The main thread takes tasks too, it is the only worker for small levels
+  MovementWorker();
 
-    // Get the Position of the current player
-    sf::Vector2f anPosition = theEntity->mProperties.Get<sf::Vector2f>("vPosition");
-    sf::Vector2u anScreen = theEntity->mProperties.Get<sf::Vector2u>("wScreen");
-    sf::IntRect anBoundingBox = theEntity->mProperties.Get<sf::IntRect>("rBoundingBox");
+  // Wait until every worker thread we woke up has finished
+  for(GQE::Uint32 anIndex = 0; anIndex < anWoken; anIndex++)
+  {
+    mWorkDone.Wait();
+  }
+}
+
+void LevelSystem::MovementThread(void* theLevelSystem)
+{
+  LevelSystem* anSystem = static_cast<LevelSystem*>(theLevelSystem);
 
-    // The map position according to player movement
-    sf::Vector2u anMapU = theEntity->mProperties.Get<sf::Vector2u>("wMapU");
-    sf::Vector2u anMapL = theEntity->mProperties.Get<sf::Vector2u>("wMapL");
-    sf::Vector2u anMapD = theEntity->mProperties.Get<sf::Vector2u>("wMapD");
-    sf::Vector2u anMapR = theEntity->mProperties.Get<sf::Vector2u>("wMapR");
+  // Take movement tasks every time RunMovement wakes us up until we are
+  // told to return
+  anSystem->mWorkStart.Wait();
+  while(anSystem->mWorkersQuit == false)
+  {
+    anSystem->MovementWorker();
+    anSystem->mWorkDone.Post();
+    anSystem->mWorkStart.Wait();
+  }
+}
 
-    // Search through each z-order map to find theEntityID provided
-    std::deque<GQE::IEntity*>::iterator anIter =
-      mScreens[anScreen.x + anScreen.y*mScreenWidth].walls.begin();
-    while(anIter != mScreens[anScreen.x + anScreen.y*mScreenWidth].walls.end())
+void LevelSystem::MovementWorker(void)
+{
+  bool anDone = false;
+  while(anDone == false)
+  {
+    // Take the next task nobody has taken yet
+    GQE::Uint32 anTask = 0;
     {
-      // Get the IEntity address first
-      GQE::IEntity* anEntity = *anIter;
+      sf::Lock anLock(mMovementMutex);
+      anTask = mNextTask++;
+    }
 
-      // Increment wall iterator
-      anIter++;
+    if(anTask < mNumMovementTasks)
+    {
+      MovementTask& anMovementTask = mMovementTasks[anTask];
+      if(mMovementPhase == MovementCollect)
+      {
+        // Calculate new MapX and MapY values for each IEntity of this screen
+        UpdateCoordinates(anMovementTask);
 
-      // Get the wMap property for this wall IEntity
-      sf::Vector2u anMap = anEntity->mProperties.Get<sf::Vector2u>("wMap");
+        // Check for treasures in our current location first
+        CheckTreasure(anMovementTask);
 
-      // Is this tile visible? then check it for wall collisions
-      if(anEntity->mProperties.Get<bool>("bVisible"))
+        // Check screen edges before we check for walls
+        CheckScreenEdges(anMovementTask);
+      }
+      else
       {
-        // Are we moving left and hit a wall?
-        if(anVelocity.x < 0.0f && anMapL == anMap)
-        {
-          // Update position to exactly next to the tile
-          anPosition.x = (float)(anMapL.x % mScreenTileWidth) * mTileWidth -
+        // Check for walls against each IEntity of this screen
+        CheckWalls(anMovementTask);
+      }
+    }
+    else
+    {
+      // Every task has been taken
+      anDone = true;
+    }
+  }
+}
+
+void LevelSystem::MergeMovement(MovementPhase thePhase)
+{
+  MovementArrays& anMove = mMovement;
+  if(thePhase == MovementCollect)
+  {
+    // Apply the treasure pickups of every screen in z-order
+    mPickups.clear();
+    for(GQE::Uint32 anTask = 0; anTask < mNumMovementTasks; anTask++)
+    {
+      mPickups.insert(mPickups.end(), mMovementTasks[anTask].pickups.begin(),
+        mMovementTasks[anTask].pickups.end());
+    }
+    std::stable_sort(mPickups.begin(), mPickups.end(), TreasureOrder());
+
+    std::vector<TreasurePickup>::iterator anPickup = mPickups.begin();
+    while(anPickup != mPickups.end())
+    {
+      // Remember the coin was collected
+      if(mCollected != NULL)
+      {
+        mCollected[anPickup->treasure / 32] |= (1U << (anPickup->treasure % 32));
+      }
+
+      // A treasure that was also a wall might have opened up this cell
+      if(anPickup->wall)
+      {
+        UpdateWall(anPickup->map);
+      }
+#if (SFML_VERSION_MAJOR >= 2)
+
+      // The coin is part of our batches if it was on the current screen
+      mBatchesDirty = mBatchesDirty || (anPickup->screen == mScreen);
+#endif
+
+      // If the player is visible to us, play the sound effect (if it has one)
+      if(anMove.visible[anPickup->entity] && mReplaying == false)
+      {
+        PlayCoin(anPickup->value);
+      }
+
+      // Increment pickup iterator
+      anPickup++;
+    }
+
+    // If a local player moved to another screen, update our animations to
+    // use it, FinishReplay does this once a replay is over
+    for(size_t i = 0; i < anMove.entity.size() && mReplaying == false; i++)
+    {
+      const sf::Vector2u anScreen(anMove.screenX[i], anMove.screenY[i]);
+      if(anMove.local[i] && anScreen != mScreen)
+      {
+        SwitchScreen(anScreen);
+      }
+    }
+  }
+  else
+  {
+    // Play our bump sound if any visible player hit a wall
+    for(size_t i = 0; i < anMove.entity.size(); i++)
+    {
+      if((anMove.events[i] & MOVE_BUMPED) && anMove.visible[i] && mReplaying == false)
+      {
+        PlayBump();
+      }
+    }
+  }
+}
+
+void LevelSystem::PlayCoin(GQE::Uint32 theValue)
+{
+  // Only play if not already playing this sound effect
 #if (SFML_VERSION_MAJOR < 2)
-            anBoundingBox.Left + anBoundingBox.GetWidth();
+  if(sf::Sound::Playing != mCoin.GetStatus())
+  {
+    // Add sound effect for the treasure according to value
+    if(theValue < 5)
+    {
+      // Use copper coin sound
+      mCoin.SetBuffer(mSounds[0].GetAsset());
+    }
+    else if(theValue >= 5 && theValue < 10)
+    {
+      // Use silver coin sound
+      mCoin.SetBuffer(mSounds[1].GetAsset());
+    }
+    else if(theValue >= 10 && theValue < 50)
+    {
+      // Use gold coin sound
+      mCoin.SetBuffer(mSounds[2].GetAsset());
+    }
+    else if(theValue >= 50 && theValue < 100)
+    {
+      // Use treasure chest sound
+      mCoin.SetBuffer(mSounds[3].GetAsset());
+    }
+    // Now play the sound chosen above
+    mCoin.Play();
+  }
 #else
-            anBoundingBox.left + anBoundingBox.width;
+  if(sf::Sound::Playing != mCoin.getStatus())
+  {
+    // Add sound effect for the treasure according to value
+    if(theValue < 5)
+    {
+      // Use copper coin sound
+      mCoin.setBuffer(mSounds[0].GetAsset());
+    }
+    else if(theValue >= 5 && theValue < 10)
+    {
+      // Use silver coin sound
+      mCoin.setBuffer(mSounds[1].GetAsset());
+    }
+    else if(theValue >= 10 && theValue < 50)
+    {
+      // Use gold coin sound
+      mCoin.setBuffer(mSounds[2].GetAsset());
+    }
+    else if(theValue >= 50 && theValue < 100)
+    {
+      // Use treasure chest sound
+      mCoin.setBuffer(mSounds[3].GetAsset());
+    }
+    // Now play the sound chosen above
+    mCoin.play();
+  }
 #endif
+}
 
-          // Cancel velocity in left direction
-          anVelocity.x = 0.0f;
-          anHit = true;
-        }
-        // Are we moving right and hit a wall?
-        else if(anVelocity.x > 0.0f && anMapR == anMap)
-        {
-          // Update position to exactly next to the tile
-          anPosition.x = (float)(anMapR.x % mScreenTileWidth) * mTileWidth -
+void LevelSystem::PlayBump(void)
+{
 #if (SFML_VERSION_MAJOR < 2)
-            anBoundingBox.Left - anBoundingBox.GetWidth();
+  // Only play if not already playing this sound effect
+  if(sf::Sound::Playing != mBump.GetStatus())
+  {
+    mBump.Play();
+  }
 #else
-            anBoundingBox.left - anBoundingBox.width;
+  // Only play if not already playing this sound effect
+  if(sf::Sound::Playing != mBump.getStatus())
+  {
+    mBump.play();
+  }
 #endif
+}
 
-          // Cancel velocity in right direction
-          anVelocity.x = 0.0f;
-          anHit = true;
-        }
-        else
-        {
-          // Do nothing
-        }
+void LevelSystem::UpdateCoordinates(MovementTask& theTask)
+{
+  MovementArrays& anMove = mMovement;
+  const size_t anCount = theTask.entities.size();
+
+  // Plain arithmetic on contiguous arrays, nothing here touches a property bag
+  for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+  {
+    const GQE::Uint32 i = theTask.entities[anIndex];
+
+    // Compute the center tile that we are currently on based on our current position
+    const GQE::Uint32 anTileCenterX = (GQE::Uint32)((anMove.x[i] + anMove.boxLeft[i] +
+      anMove.boxWidth[i] / 2) / mTileWidth) % mScreenTileWidth;
+    const GQE::Uint32 anTileCenterY = (GQE::Uint32)((anMove.y[i] + anMove.boxTop[i] +
+      anMove.boxHeight[i] / 2) / mTileHeight) % mScreenTileHeight;
+
+    // Compute the tile if moving left, right, up, or down
+    const float anLeft = anMove.x[i] + anMove.velocityX[i] + anMove.boxLeft[i];
+    const float anTop = anMove.y[i] + anMove.velocityY[i] + anMove.boxTop[i];
+    anMove.tileLeft[i] = (GQE::Uint32)(anLeft / mTileWidth) % mScreenTileWidth;
+    anMove.tileRight[i] = (GQE::Uint32)((anLeft + anMove.boxWidth[i]) / mTileWidth) % mScreenTileWidth;
+    anMove.tileUp[i] = (GQE::Uint32)(anTop / mTileHeight) % mScreenTileHeight;
+    anMove.tileDown[i] = (GQE::Uint32)((anTop + anMove.boxHeight[i]) / mTileHeight) % mScreenTileHeight;
+
+    // Compute the map coordinates for no movement
+    anMove.mapX[i] = anTileCenterX + anMove.screenX[i] * mScreenTileWidth;
+    anMove.mapY[i] = anTileCenterY + anMove.screenY[i] * mScreenTileHeight;
+  }
+}
+
+void LevelSystem::CheckTreasure(MovementTask& theTask)
+{
+  MovementArrays& anMove = mMovement;
+  const size_t anCount = theTask.entities.size();
+  for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+  {
+    const GQE::Uint32 i = theTask.entities[anIndex];
+    const sf::Vector2u anMapCC(anMove.mapX[i], anMove.mapY[i]);
+    const sf::Vector2u anScreen(anMove.screenX[i], anMove.screenY[i]);
+
+    // The cell of our current position on our current screen
+    const GQE::Uint16 anCellIndex = (GQE::Uint16)(
+      (anMapCC.y % mScreenTileHeight) * mScreenTileWidth + anMapCC.x % mScreenTileWidth);
+
+    // Find the first treasure of our current cell, the treasures of each cell
+    // are next to each other in the treasure list of the screen
+    ScreenInfo* anInfo = GetScreen(anScreen);
+    TileRef* anIter = NULL;
+    TileRef* anEnd = NULL;
+    if(anInfo != NULL && anInfo->treasureCells != NULL && anInfo->treasureCells[anCellIndex] > 0)
+    {
+      anIter = anInfo->treasures + anInfo->treasureCells[anCellIndex] - 1;
+      anEnd = anInfo->treasures + anInfo->numTreasures;
+    }
+    while(anIter != anEnd && anIter->cell == anCellIndex)
+    {
+      // Get the treasure cell and its bit in the collected bitset first
+      TileCell& anCell = anInfo->cells[
+        anIter->layer * mScreenTileWidth * mScreenTileHeight + anIter->cell];
+      const GQE::Uint32 anTreasure = anInfo->firstTreasure +
+        (GQE::Uint32)(anIter - anInfo->treasures);
+
+      // Increment coin iterator
+      anIter++;
+
+      // Is this treasure still visible? only this task touches the cells of
+      // this screen, the collected bitset is updated later by MergeMovement
+      if(anCell.flags & TILE_VISIBLE)
+      {
+        // Get the value for this coin or treasure chest
+        GQE::Uint32 anValue = mTileTypes[anCell.type - 1].value;
+
+        // Make the coin disappear
+        anCell.flags &= ~TILE_VISIBLE;
+
+        // Add to our players total points according to the value of the treasure
+        anMove.score[i] += anValue;
+
+        // Let MergeMovement handle everything shared with other screens
+        TreasurePickup anPickup;
+        anPickup.entity = i;
+        anPickup.treasure = anTreasure;
+        anPickup.value = anValue;
+        anPickup.map = anMapCC;
+        anPickup.screen = anScreen;
+        anPickup.wall = (anCell.flags & TILE_WALL) != 0;
+        theTask.pickups.push_back(anPickup);
+      }
+    } //while(anIter != anEnd)
+  } // for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+}
+
+
+void LevelSystem::CheckWalls(MovementTask& theTask)
+{
+  MovementArrays& anMove = mMovement;
+  const size_t anCount = theTask.entities.size();
+  for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+  {
+    const GQE::Uint32 i = theTask.entities[anIndex];
+
+    // Get the Velocity of the current player
+    sf::Vector2f anVelocity(anMove.velocityX[i], anMove.velocityY[i]);
+
+    // Should we skip this check because we aren't moving?
+    if(anVelocity.x > 0.1f || anVelocity.x < -0.1f || anVelocity.y > 0.1f || anVelocity.y < -0.1f)
+    {
+      // Did we hit a wall?
+      bool anHit = false;
+
+      // Get the Position of the current player
+      sf::Vector2f anPosition(anMove.x[i], anMove.y[i]);
+      const sf::Vector2u anScreen(anMove.screenX[i], anMove.screenY[i]);
+      const float anBoxLeft = anMove.boxLeft[i];
+      const float anBoxTop = anMove.boxTop[i];
+      const float anBoxWidth = anMove.boxWidth[i];
+      const float anBoxHeight = anMove.boxHeight[i];
+
+      // Are we moving left or right? then sweep every row we overlap
+      if(anVelocity.x < 0.0f || anVelocity.x > 0.0f)
+      {
+        const float anEdge = anPosition.x + anBoxLeft + (anVelocity.x > 0.0f ? anBoxWidth : 0.0f);
+        const float anTime = SweepWalls(anScreen, anEdge, anVelocity.x,
+          anPosition.y + anBoxTop, anBoxHeight, false);
 
-        // Are we moving up and hit a wall?
-        if(anVelocity.y < 0.0f && anMapU == anMap)
+        // Did we hit a wall?
+        if(anTime < 1.0f)
         {
+          const float anSlide = SlideCorner(anScreen, anEdge, anVelocity.x,
+            anPosition.y + anBoxTop, anBoxHeight, false, anTime);
+
           // Update position to exactly next to the tile
-          anPosition.y = (float)(anMapU.y % mScreenTileHeight) * mTileHeight -
-#if (SFML_VERSION_MAJOR < 2)
-            anBoundingBox.Top + anBoundingBox.GetHeight();
-#else
-            anBoundingBox.top + anBoundingBox.height;
-#endif
+          anPosition.x += anVelocity.x * anTime;
 
-          // Cancel velocity in up direction
-          anVelocity.y = 0.0f;
-          anHit = true;
+          // Cancel velocity in left or right direction
+          anVelocity.x = 0.0f;
+
+          // Slide around the corner we caught or stop at the wall
+          if(anSlide < 0.0f || anSlide > 0.0f)
+          {
+            anPosition.y += anSlide;
+          }
+          else
+          {
+            anHit = true;
+          }
         }
-        // Are we moving down and hit a wall?
-        else if(anVelocity.y > 0.0f && anMapD == anMap)
+      }
+
+      // Are we moving up or down? then sweep every column we (now) overlap
+      if(anVelocity.y < 0.0f || anVelocity.y > 0.0f)
+      {
+        const float anEdge = anPosition.y + anBoxTop + (anVelocity.y > 0.0f ? anBoxHeight : 0.0f);
+        const float anTime = SweepWalls(anScreen, anEdge, anVelocity.y,
+          anPosition.x + anBoxLeft, anBoxWidth, true);
+
+        // Did we hit a wall?
+        if(anTime < 1.0f)
         {
+          const float anSlide = SlideCorner(anScreen, anEdge, anVelocity.y,
+            anPosition.x + anBoxLeft, anBoxWidth, true, anTime);
+
           // Update position to exactly next to the tile
-          anPosition.y = (float)(anMapD.y % mScreenTileHeight) * mTileHeight -
-#if (SFML_VERSION_MAJOR < 2)
-            anBoundingBox.Top - anBoundingBox.GetHeight();
-#else
-            anBoundingBox.top - anBoundingBox.height;
-#endif
+          anPosition.y += anVelocity.y * anTime;
 
-          // Cancel velocity in down direction
+          // Cancel velocity in up or down direction
           anVelocity.y = 0.0f;
-          anHit = true;
-        }
-        else
-        {
-          // Do nothing
+
+          // Slide around the corner we caught or stop at the wall
+          if(anSlide < 0.0f || anSlide > 0.0f)
+          {
+            anPosition.x += anSlide;
+          }
+          else
+          {
+            anHit = true;
+          }
         }
       }
-      // Special quick exit check if both velocities have been cancelled exit out
-      if(anVelocity.x < 0.1f && anVelocity.x > -0.1f && anVelocity.y < 0.1f && anVelocity.y > -0.1f)
-      {
-        // Exit our while loop, no need to keep checking since we cancelled all movement
-        break;
-      }
-    } //while(anIter != mScreens[anScreen.x + anScreen.y*mScreenWidth].walls.end())
 
-    // Update our velocity value
-    theEntity->mProperties.Set<sf::Vector2f>("vVelocity", anVelocity);
+      // Update our velocity value
+      anMove.velocityX[i] = anVelocity.x;
+      anMove.velocityY[i] = anVelocity.y;
 
-    // Update our position value
-    theEntity->mProperties.Set<sf::Vector2f>("vPosition", anPosition);
+      // Update our position value
+      anMove.x[i] = anPosition.x;
+      anMove.y[i] = anPosition.y;
 
-    // If the player is visible to us, play the sound effect
-    if(anHit && theEntity->mProperties.Get<bool>("bVisible"))
-    {
-#if (SFML_VERSION_MAJOR < 2)
-      // Only play if not already playing this sound effect
-      if(sf::Sound::Playing != mBump.GetStatus())
-      {
-        mBump.Play();
-      }
-#else
-      // Only play if not already playing this sound effect
-      if(sf::Sound::Playing != mBump.getStatus())
+      // Let MergeMovement play the bump sound in z-order
+      if(anHit)
       {
-        mBump.play();
+        anMove.events[i] |= MOVE_BUMPED;
       }
-#endif
     }
-  }
+  } // for(size_t anIndex = 0; anIndex < anCount; anIndex++)
 }
 
-void LevelSystem::CheckScreenEdges(GQE::IEntity* theEntity)
+float LevelSystem::SweepWalls(sf::Vector2u theScreen, float theEdge, float theDelta,
+    float theStart, float theSize, bool theVertical) const
 {
-  // Get the vVelocity property of the current player
-  sf::Vector2f anVelocity = theEntity->mProperties.Get<sf::Vector2f>("vVelocity");
-  // Get the vPosition property of the current player
-  sf::Vector2f anPosition = theEntity->mProperties.Get<sf::Vector2f>("vPosition");
-  // Get the wScreen property of the current player
-  sf::Vector2u anScreen = theEntity->mProperties.Get<sf::Vector2u>("wScreen");
-  // Get the rBoundingBox property of the current player
-  sf::IntRect anBoundingBox = theEntity->mProperties.Get<sf::IntRect>("rBoundingBox");
-
-  // The map position according to player movement
-  sf::Vector2u anMapU = theEntity->mProperties.Get<sf::Vector2u>("wMapU");
-  sf::Vector2u anMapL = theEntity->mProperties.Get<sf::Vector2u>("wMapL");
-  sf::Vector2u anMapD = theEntity->mProperties.Get<sf::Vector2u>("wMapD");
-  sf::Vector2u anMapR = theEntity->mProperties.Get<sf::Vector2u>("wMapR");
-
-  // Are we moving left and hit a screen edge?
-  if(anVelocity.x < 0.0f && 0 == (anMapR.x % mScreenTileWidth) && anScreen.x > 0)
-  {
-    // Update position to exactly next to the tile
-    anPosition.x = (float)(mScreenTileWidth - 1) * mTileWidth -
-#if (SFML_VERSION_MAJOR < 2)
-      anBoundingBox.Left;
-#else
-      anBoundingBox.left;
-#endif
-
-    // Update our screen value
-    anScreen.x--;
-  }
-  // Are we moving right and hit a screen edge?
-  else if(anVelocity.x > 0.0f && (mScreenTileWidth - 1) == (anMapL.x % mScreenTileWidth) &&
-    anScreen.x < mScreenWidth)
+  // Assume we can move the whole way
+  float anResult = 1.0f;
+
+  const float anSize = (float)(theVertical ? mTileHeight : mTileWidth);
+  const int anCells = (int)(theVertical ? mScreenTileHeight : mScreenTileWidth);
+
+  // Find every line of cells across the axis the bounding box overlaps, a
+  // box that only touches the side of a line doesn't overlap it
+  const float anLineSize = (float)(theVertical ? mTileWidth : mTileHeight);
+  const int anLines = (int)(theVertical ? mScreenTileWidth : mScreenTileHeight);
+  const int anFirstLine = std::max((int)std::floor(theStart / anLineSize), 0);
+  const int anLastLine = std::min((int)std::ceil((theStart + theSize) / anLineSize) - 1,
+    anLines - 1);
+
+  // Only the cells entirely ahead of theEdge are walked, the cell theEdge
+  // is in now can't be a wall or we would already be inside of it
+  int anCell;
+  int anLast;
+  int anStep;
+  if(theDelta > 0.0f)
   {
-#if (SFML_VERSION_MAJOR < 2)
-    anPosition.x = (float)-anBoundingBox.Left;
-#else
-    anPosition.x = (float)-anBoundingBox.left;
-#endif
-
-    // Update our screen value
-    anScreen.x++;
+    anCell = (int)std::ceil(theEdge / anSize);
+    anLast = std::min((int)std::ceil((theEdge + theDelta) / anSize) - 1, anCells - 1);
+    anStep = 1;
   }
   else
   {
-    // Do nothing
+    anCell = (int)std::floor(theEdge / anSize) - 1;
+    anLast = std::max((int)std::floor((theEdge + theDelta) / anSize), 0);
+    anStep = -1;
   }
 
-  // Are we moving up and hit a screen edge?
-  if(anVelocity.y < 0.0f && 0 == (anMapD.y % mScreenTileHeight) && anScreen.y > 0)
+  // Walk each cell crossed in order until we find the first wall in any
+  // line we overlap, cells beyond the edge of theScreen are left to
+  // CheckScreenEdges
+  while(anCell >= 0 && anCell < anCells && (anCell - anLast) * anStep <= 0 && anResult == 1.0f)
   {
-    anPosition.y = (float)(mScreenTileHeight - 1) * mTileHeight -
-#if (SFML_VERSION_MAJOR < 2)
-      anBoundingBox.Top;
-#else
-      anBoundingBox.top;
-#endif
+    for(int anLine = anFirstLine; anLine <= anLastLine && anResult == 1.0f; anLine++)
+    {
+      const sf::Vector2u anMap = theVertical ?
+        sf::Vector2u(theScreen.x * mScreenTileWidth + anLine,
+          theScreen.y * mScreenTileHeight + anCell) :
+        sf::Vector2u(theScreen.x * mScreenTileWidth + anCell,
+          theScreen.y * mScreenTileHeight + anLine);
+      if(IsWall(anMap))
+      {
+        // Compute when theEdge touches the near side of this wall, every
+        // wall in this cell line is touched at the same time
+        const float anSide = (float)(theDelta > 0.0f ? anCell : anCell + 1) * anSize;
+        anResult = std::max((anSide - theEdge) / theDelta, 0.0f);
+      }
+    }
 
-    // Update our screen value
-    anScreen.y--;
+    // Move on to the next cell crossed
+    anCell += anStep;
   }
-  // Are we moving down and hit a screen edge?
-  else if(anVelocity.y > 0.0f && (mScreenTileHeight-1) == (anMapU.y % mScreenTileHeight) &&
-    anScreen.y < mScreenHeight)
-  {
-#if (SFML_VERSION_MAJOR < 2)
-    anPosition.y = (float)-anBoundingBox.Top;
-#else
-    anPosition.y = (float)-anBoundingBox.top;
-#endif
 
-    // Update our screen value
-    anScreen.y++;
+  // Return the fraction of theDelta we can move
+  return anResult;
+}
+
+float LevelSystem::SlideCorner(sf::Vector2u theScreen, float theEdge, float theDelta,
+    float theStart, float theSize, bool theVertical, float theTime) const
+{
+  // Assume we have to stop at the wall
+  float anResult = 0.0f;
+
+  const float anLineSize = (float)(theVertical ? mTileWidth : mTileHeight);
+  const float anLimit = anLineSize / CORNER_SLIDE;
+  const float anSpeed = std::fabs(theDelta);
+
+  // How far the box reaches into its first and last line of cells, sliding
+  // out of one of them only ever leaves lines, it never enters new ones
+  const float anFirst = std::ceil(theStart / anLineSize) * anLineSize - theStart;
+  const float anLast = (theStart + theSize) -
+    std::floor((theStart + theSize) / anLineSize) * anLineSize;
+
+  // Slide away from whichever line the box barely overlaps, as long as
+  // that gets it further than where it was stopped
+  if(anFirst > 0.0f && anFirst < anLimit &&
+      SweepWalls(theScreen, theEdge, theDelta, theStart + anFirst, theSize, theVertical) > theTime)
+  {
+    anResult = std::min(anFirst, anSpeed);
   }
-  else
+  else if(anLast > 0.0f && anLast < anLimit &&
+      SweepWalls(theScreen, theEdge, theDelta, theStart - anLast, theSize, theVertical) > theTime)
   {
-    // Do nothing
+    anResult = -std::min(anLast, anSpeed);
   }
 
-  // Update our Position value with any changes made above
-  theEntity->mProperties.Set<sf::Vector2f>("vPosition", anPosition);
+  // Return the pixels to slide across the axis
+  return anResult;
+}
+
+bool LevelSystem::IsWall(sf::Vector2u theMap) const
+{
+  // Assume theMap cell is not a wall
+  bool anResult = false;
+
+  const GQE::Uint32 anMapWidth = mScreenWidth * mScreenTileWidth;
+  if(mWalls != NULL && theMap.x < anMapWidth && theMap.y < mScreenHeight * mScreenTileHeight)
+  {
+    const GQE::Uint32 anBit = theMap.y * anMapWidth + theMap.x;
+    anResult = (mWalls[anBit / 32] & (1U << (anBit % 32))) != 0;
+  }
 
-  // Update our Screen value with any changes made above
-  theEntity->mProperties.Set<sf::Vector2u>("wScreen", anScreen);
+  // Return true if theMap cell is a wall
+  return anResult;
+}
 
-  // If local player, update our animations to use the new screen
-  if(theEntity->mProperties.Get<bool>("bNetworkLocal"))
+void LevelSystem::UpdateWall(sf::Vector2u theMap)
+{
+  const GQE::Uint32 anScreenTiles = mScreenTileWidth * mScreenTileHeight;
+  ScreenInfo* anInfo = GetScreen(sf::Vector2u(theMap.x / mScreenTileWidth,
+    theMap.y / mScreenTileHeight));
+  if(mWalls != NULL && anInfo != NULL && anInfo->cells != NULL)
   {
-    SwitchScreen(anScreen);
+    // The cell is still a wall if any layer has a visible wall tile there
+    const GQE::Uint32 anCell = (theMap.y % mScreenTileHeight) * mScreenTileWidth +
+      theMap.x % mScreenTileWidth;
+    bool anWall = false;
+    for(GQE::Uint32 anLayer = 0; anLayer < anInfo->layers && anWall == false; anLayer++)
+    {
+      const GQE::Uint8 anFlags = anInfo->cells[anLayer * anScreenTiles + anCell].flags;
+      anWall = (anFlags & TILE_WALL) && (anFlags & TILE_VISIBLE);
+    }
+
+    // Update the bit for this cell
+    const GQE::Uint32 anBit = theMap.y * mScreenWidth * mScreenTileWidth + theMap.x;
+    if(anWall)
+    {
+      mWalls[anBit / 32] |= (1U << (anBit % 32));
+    }
+    else
+    {
+      mWalls[anBit / 32] &= ~(1U << (anBit % 32));
+    }
   }
 }
 
+void LevelSystem::CheckScreenEdges(MovementTask& theTask)
+{
+  MovementArrays& anMove = mMovement;
+  const size_t anCount = theTask.entities.size();
+  for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+  {
+    const GQE::Uint32 i = theTask.entities[anIndex];
+
+    // Get the velocity, position and screen of the current player
+    const sf::Vector2f anVelocity(anMove.velocityX[i], anMove.velocityY[i]);
+    sf::Vector2f anPosition(anMove.x[i], anMove.y[i]);
+    sf::Vector2u anScreen(anMove.screenX[i], anMove.screenY[i]);
+
+    // Are we moving left and hit a screen edge?
+    if(anVelocity.x < 0.0f && 0 == anMove.tileRight[i] && anScreen.x > 0)
+    {
+      // Update position to exactly next to the tile
+      anPosition.x = (float)(mScreenTileWidth - 1) * mTileWidth - anMove.boxLeft[i];
+
+      // Update our screen value
+      anScreen.x--;
+    }
+    // Are we moving right and hit a screen edge?
+    else if(anVelocity.x > 0.0f && (mScreenTileWidth - 1) == anMove.tileLeft[i] &&
+      anScreen.x < mScreenWidth)
+    {
+      anPosition.x = -anMove.boxLeft[i];
+
+      // Update our screen value
+      anScreen.x++;
+    }
+    else
+    {
+      // Do nothing
+    }
+
+    // Are we moving up and hit a screen edge?
+    if(anVelocity.y < 0.0f && 0 == anMove.tileDown[i] && anScreen.y > 0)
+    {
+      anPosition.y = (float)(mScreenTileHeight - 1) * mTileHeight - anMove.boxTop[i];
+
+      // Update our screen value
+      anScreen.y--;
+    }
+    // Are we moving down and hit a screen edge?
+    else if(anVelocity.y > 0.0f && (mScreenTileHeight-1) == anMove.tileUp[i] &&
+      anScreen.y < mScreenHeight)
+    {
+      anPosition.y = -anMove.boxTop[i];
+
+      // Update our screen value
+      anScreen.y++;
+    }
+    else
+    {
+      // Do nothing
+    }
+
+    // Update our Position value with any changes made above
+    anMove.x[i] = anPosition.x;
+    anMove.y[i] = anPosition.y;
+
+    // Update our Screen value with any changes made above
+    anMove.screenX[i] = anScreen.x;
+    anMove.screenY[i] = anScreen.y;
+  } // for(size_t anIndex = 0; anIndex < anCount; anIndex++)
+}
+
 void LevelSystem::DrawBar(void)
 {
   if(mLoader != NULL)
   {
+    // Get the percent complete published by the loader thread
+    float anProgress = 0.0f;
+    {
+      sf::Lock anLock(mLoader->mutex);
+      anProgress = mLoader->progress;
+    }
+
     // Get our Loading screen texture
     sf::Sprite anSprite(mLoader->loading.GetAsset());
 
@@ -864,7 +1499,7 @@ void LevelSystem::DrawBar(void)
 #if (SFML_VERSION_MAJOR < 2)
     // FIXME: Replace RectangleShape with Rectangle static constructor
     //sf::RectangleShape anBar(sf::Vector2f(
-    //      float(mApp.mWindow.GetWidth()-60)*mLoader->percent, 35));
+    //      float(mApp.mWindow.GetWidth()-60)*anProgress, 35));
     sf::String  anPercent("", mFont, 30.0f);
     // Position and color for the tile being loaded/progress bar
     anPercent.SetColor(sf::Color(0,255,0,128));
@@ -874,7 +1509,7 @@ void LevelSystem::DrawBar(void)
     //anBar.SetFillColor(sf::Color(0,0,128,255));
 #else
     sf::RectangleShape anBar(sf::Vector2f(
-          float(mApp.mWindow.getSize().x-60)*mLoader->percent, 35));
+          float(mApp.mWindow.getSize().x-60)*anProgress, 35));
     sf::Text    anPercent("", mFont, 30);
     // Position and color for the tile being loaded/progress bar
     anPercent.setColor(sf::Color(0,255,0,128));
@@ -890,7 +1525,7 @@ void LevelSystem::DrawBar(void)
     // anValue is our percent complete to be displayed
     anPercentString.precision(1);
     anPercentString.width(7);
-    anPercentString << std::fixed << mLoader->percent * 100.0f << "%";
+    anPercentString << std::fixed << anProgress * 100.0f << "%";
 
 #if (SFML_VERSION_MAJOR < 2)
     // Assign our Percent Complete string value created above
@@ -916,51 +1551,472 @@ void LevelSystem::DrawBar(void)
 
 void LevelSystem::DrawTiles(void)
 {
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >& anScreen =
-    mScreens[mScreen.x + mScreen.y*mScreenWidth].tiles;
+  ScreenInfo* anInfo = GetScreen(mScreen);
 
-  // Search through each z-order map to find theEntityID provided
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-  anIter = anScreen.begin();
-  while(anIter != anScreen.end())
+  // Make sure the current screen has something to draw
+  if(anInfo != NULL && anInfo->cells != NULL)
   {
-    std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-    while(anQueue != anIter->second.end())
+    // Update the sprite rect of each animated tile type from its shared property bag,
+    // the AnimationSystem works in tileset coordinates so move it into the atlas
+    for(GQE::Uint32 anAnimation = 0; anAnimation < anInfo->numAnimations; anAnimation++)
     {
-      // Get the IEntity address first
-      GQE::IEntity* anEntity = *anQueue;
-
-      // Increment the IEntity iterator second
-      anQueue++;
-
-      // See if this IEntity is visible, if so draw it now
-      if(anEntity->mProperties.Get<bool>("bVisible"))
-      {
-        // Get the other pseudo RenderSystem properties now
-        sf::Sprite anSprite=anEntity->mProperties.Get<sf::Sprite>("Sprite");
+      TileType& anType = mTileTypes[anInfo->animations[anAnimation]];
+      sf::IntRect anRect = anType.entity->mProperties.Get<sf::IntRect>("rSpriteRect");
 #if SFML_VERSION_MAJOR<2
-        anSprite.SetPosition(anEntity->mProperties.Get<sf::Vector2f>("vPosition"));
-        anSprite.SetSubRect(anEntity->mProperties.Get<sf::IntRect>("rSpriteRect"));
-        mApp.mWindow.Draw(anSprite);
+      anRect.Offset(anType.offset.x, anType.offset.y);
+      anType.sprite.SetSubRect(anRect);
 #else
-        anSprite.setPosition(anEntity->mProperties.Get<sf::Vector2f>("vPosition"));
-        anSprite.setTextureRect(anEntity->mProperties.Get<sf::IntRect>("rSpriteRect"));
-        mApp.mWindow.draw(anSprite);
+      anRect.left += anType.offset.x;
+      anRect.top += anType.offset.y;
+      anType.sprite.setTextureRect(anRect);
 #endif
-      } // if(anEntity->mProperties.Get<bool>("bVisible"))
-    } // while(anQueue != anIter->second.end())
+    }
 
-    // Increment map iterator
-    anIter++;
-  } //while(anIter != mEntities.end())
+#if (SFML_VERSION_MAJOR < 2)
+    // Draw each layer in order, cell by cell
+    const GQE::Uint32 anScreenTiles = mScreenTileWidth * mScreenTileHeight;
+    for(GQE::Uint32 anLayer = 0; anLayer < anInfo->layers; anLayer++)
+    {
+      const TileCell* anCells = anInfo->cells + anLayer * anScreenTiles;
+      for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles; anIndex++)
+      {
+        const TileCell& anCell = anCells[anIndex];
+
+        // See if this cell has a visible tile, if so draw it now
+        if(anCell.type > 0 && (anCell.flags & (TILE_VISIBLE | TILE_HIDDEN)) == TILE_VISIBLE)
+        {
+          sf::Sprite& anSprite = mTileTypes[anCell.type - 1].sprite;
+          anSprite.SetPosition(sf::Vector2f(
+            (float)(anIndex % mScreenTileWidth) * mTileWidth,
+            (float)(anIndex / mScreenTileWidth) * mTileHeight));
+          mApp.mWindow.Draw(anSprite);
+        } // if(anCell.type > 0 && ...)
+      } // for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles; anIndex++)
+    } // for(GQE::Uint32 anLayer = 0; anLayer < anInfo->layers; anLayer++)
+#else
+    // Rebuild our batches if a treasure on this screen was picked up
+    if(mBatchesDirty)
+    {
+      LoadTileBatches();
+    }
+
+    // Only the vertices of animated tiles change from frame to frame
+    std::vector<TileQuad>::iterator anQuad = mAnimatedQuads.begin();
+    while(anQuad != mAnimatedQuads.end())
+    {
+      const sf::IntRect& anRect = mTileTypes[anQuad->type].sprite.getTextureRect();
+      sf::Vertex* anVertex = &mBatches[anQuad->batch].vertices[anQuad->vertex];
+      anVertex[0].texCoords = sf::Vector2f((float)anRect.left, (float)anRect.top);
+      anVertex[1].texCoords = sf::Vector2f((float)(anRect.left + anRect.width), (float)anRect.top);
+      anVertex[2].texCoords = sf::Vector2f((float)(anRect.left + anRect.width),
+        (float)(anRect.top + anRect.height));
+      anVertex[3].texCoords = sf::Vector2f((float)anRect.left, (float)(anRect.top + anRect.height));
+
+      // Increment animated quad iterator
+      anQuad++;
+    }
+
+    // Draw the baked static layers first as a single quad
+    if(mBaked != NULL)
+    {
+      mApp.mWindow.draw(sf::Sprite(mBaked->getTexture()));
+    }
+
+    // Draw each batch in layer order, one draw call per layer and atlas page
+    std::vector<TileBatch>::iterator anBatch = mBatches.begin();
+    while(anBatch != mBatches.end())
+    {
+      mApp.mWindow.draw(anBatch->vertices, sf::RenderStates(anBatch->texture));
+
+      // Increment batch iterator
+      anBatch++;
+    }
+
+    // Bake one of our neighbours now so switching screens is instant
+    BakeNextScreen();
+#endif
+  } // if(anInfo != NULL && anInfo->cells != NULL)
+}
+
+#if (SFML_VERSION_MAJOR >= 2)
+void LevelSystem::LoadTileBatches(void)
+{
+  // Start over with no batches at all
+  mBatches.clear();
+  mAnimatedQuads.clear();
+  mBatchesDirty = false;
+  mBaked = NULL;
+
+  // Forget the baked screens that are no longer next to the new screen
+  DropBakedScreens(false);
+
+  ScreenInfo* anInfo = GetScreen(mScreen);
+  if(anInfo != NULL && anInfo->cells != NULL)
+  {
+    // The bottom static layers are drawn from the baked screen if we have one
+    GQE::Uint32 anFirstLayer = 0;
+    mBaked = BakeScreen(mScreen);
+    if(mBaked != NULL)
+    {
+      anFirstLayer = anInfo->staticLayers;
+    }
+
+    // Every other layer gets batched, remembering the animated tiles
+    AddTileBatches(*anInfo, anFirstLayer, anInfo->layers, mBatches, &mAnimatedQuads);
+  }
+}
+
+void LevelSystem::AddTileBatches(const ScreenInfo& theInfo, GQE::Uint32 theFirstLayer,
+    GQE::Uint32 theLastLayer, std::vector<TileBatch>& theBatches,
+    std::vector<TileQuad>* theQuads)
+{
+  const GQE::Uint32 anScreenTiles = mScreenTileWidth * mScreenTileHeight;
+  for(GQE::Uint32 anLayer = theFirstLayer; anLayer < theLastLayer; anLayer++)
+  {
+    // Batches of earlier layers must be drawn first, never add to them
+    const size_t anFirst = theBatches.size();
+
+    const TileCell* anCells = theInfo.cells + anLayer * anScreenTiles;
+    for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles; anIndex++)
+    {
+      const TileCell& anCell = anCells[anIndex];
+
+      // Only visible tiles that aren't hidden are added to a batch
+      if(anCell.type > 0 && (anCell.flags & (TILE_VISIBLE | TILE_HIDDEN)) == TILE_VISIBLE)
+      {
+        const sf::Sprite& anSprite = mTileTypes[anCell.type - 1].sprite;
+
+        // Find the batch of this layer using the same atlas page
+        size_t anBatch = anFirst;
+        while(anBatch < theBatches.size() && theBatches[anBatch].texture != anSprite.getTexture())
+        {
+          anBatch++;
+        }
+        if(anBatch == theBatches.size())
+        {
+          TileBatch anNew;
+          anNew.texture = anSprite.getTexture();
+          anNew.vertices.setPrimitiveType(sf::Quads);
+          theBatches.push_back(anNew);
+        }
+
+        // Remember the vertices of animated tiles so DrawTiles can update them
+        if(theQuads != NULL && (anCell.flags & TILE_ANIMATION))
+        {
+          TileQuad anQuad;
+          anQuad.batch = (GQE::Uint32)anBatch;
+          anQuad.vertex = theBatches[anBatch].vertices.getVertexCount();
+          anQuad.type = (GQE::Uint16)(anCell.type - 1);
+          theQuads->push_back(anQuad);
+        }
+
+        // Add the four corners of this tile
+        const sf::IntRect& anRect = anSprite.getTextureRect();
+        const float anLeft = (float)(anIndex % mScreenTileWidth) * mTileWidth;
+        const float anTop = (float)(anIndex / mScreenTileWidth) * mTileHeight;
+        sf::VertexArray& anVertices = theBatches[anBatch].vertices;
+        anVertices.append(sf::Vertex(sf::Vector2f(anLeft, anTop),
+          sf::Vector2f((float)anRect.left, (float)anRect.top)));
+        anVertices.append(sf::Vertex(sf::Vector2f(anLeft + anRect.width, anTop),
+          sf::Vector2f((float)(anRect.left + anRect.width), (float)anRect.top)));
+        anVertices.append(sf::Vertex(sf::Vector2f(anLeft + anRect.width, anTop + anRect.height),
+          sf::Vector2f((float)(anRect.left + anRect.width), (float)(anRect.top + anRect.height))));
+        anVertices.append(sf::Vertex(sf::Vector2f(anLeft, anTop + anRect.height),
+          sf::Vector2f((float)anRect.left, (float)(anRect.top + anRect.height))));
+      } // if(anCell.type > 0 && ...)
+    } // for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles; anIndex++)
+  } // for(GQE::Uint32 anLayer = theFirstLayer; anLayer < theLastLayer; anLayer++)
+}
+
+sf::RenderTexture* LevelSystem::BakeScreen(sf::Vector2u theScreen)
+{
+  // Assume theScreen can't be baked
+  sf::RenderTexture* anResult = NULL;
+
+  ScreenInfo* anInfo = GetScreen(theScreen);
+  if(anInfo != NULL && anInfo->cells != NULL && anInfo->staticLayers > 0)
+  {
+    const GQE::Uint32 anIndex = theScreen.x + theScreen.y*mScreenWidth;
+
+    // Have we already baked this screen?
+    std::map<const GQE::Uint32, sf::RenderTexture*>::iterator anIter =
+      mBakedScreens.find(anIndex);
+    if(anIter != mBakedScreens.end())
+    {
+      anResult = anIter->second;
+    }
+    else
+    {
+      anResult = new(std::nothrow) sf::RenderTexture();
+      if(anResult != NULL && anResult->create(mScreenTileWidth * mTileWidth,
+            mScreenTileHeight * mTileHeight))
+      {
+        // Draw every static layer of theScreen once
+        std::vector<TileBatch> anBatches;
+        AddTileBatches(*anInfo, 0, anInfo->staticLayers, anBatches, NULL);
+        anResult->clear(sf::Color(0, 0, 0, 0));
+        std::vector<TileBatch>::iterator anBatch = anBatches.begin();
+        while(anBatch != anBatches.end())
+        {
+          anResult->draw(anBatch->vertices, sf::RenderStates(anBatch->texture));
+
+          // Increment batch iterator
+          anBatch++;
+        }
+        anResult->display();
+
+        // Remember the baked screen for the next time we need it
+        mBakedScreens[anIndex] = anResult;
+      }
+      else
+      {
+        WLOG() << "LevelSystem::BakeScreen(" << theScreen.x << ", " << theScreen.y
+          << ") Unable to create render texture!" << std::endl;
+
+        // Batch every layer of this screen instead
+        delete anResult;
+        anResult = NULL;
+      }
+    }
+  }
+
+  // Return the baked screen or NULL if it wasn't baked
+  return anResult;
+}
+
+void LevelSystem::BakeNextScreen(void)
+{
+  // Bake at most one neighbour of the current screen each time we are called
+  bool anBaked = false;
+  for(int anY = -1; anY <= 1 && anBaked == false; anY++)
+  {
+    for(int anX = -1; anX <= 1 && anBaked == false; anX++)
+    {
+      const sf::Vector2u anScreen(mScreen.x + anX, mScreen.y + anY);
+      ScreenInfo* anInfo = GetScreen(anScreen);
+      if(anInfo != NULL && anInfo->staticLayers > 0 &&
+          mBakedScreens.find(anScreen.x + anScreen.y*mScreenWidth) == mBakedScreens.end())
+      {
+        BakeScreen(anScreen);
+        anBaked = true;
+      }
+    }
+  }
+}
+
+void LevelSystem::DropBakedScreens(bool theAll)
+{
+  std::map<const GQE::Uint32, sf::RenderTexture*>::iterator anIter = mBakedScreens.begin();
+  while(anIter != mBakedScreens.end())
+  {
+    // Distance in screens from the current screen
+    const int anX = (int)(anIter->first % (mScreenWidth > 0 ? mScreenWidth : 1)) - (int)mScreen.x;
+    const int anY = (int)(anIter->first / (mScreenWidth > 0 ? mScreenWidth : 1)) - (int)mScreen.y;
+
+    // Keep the current screen and its neighbours around
+    if(theAll || anX < -1 || anX > 1 || anY < -1 || anY > 1)
+    {
+      delete anIter->second;
+      mBakedScreens.erase(anIter++);
+    }
+    else
+    {
+      // Increment baked screen iterator
+      anIter++;
+    }
+  }
 }
+#endif
 
 void LevelSystem::HandleInit(GQE::IEntity* theEntity)
 {
+  // Resolve the property handles of theEntity once
+  GetPlayerProperties(theEntity);
 }
 
 void LevelSystem::HandleCleanup(GQE::IEntity* theEntity)
 {
+  std::map<const GQE::typeEntityID, PlayerProperties>::iterator anIter =
+    mPlayerProperties.find(theEntity->GetID());
+  if(anIter != mPlayerProperties.end())
+  {
+    // Move the last IEntity into the slot of theEntity in mPlayers
+    const size_t anIndex = anIter->second.index;
+    mPlayers[anIndex] = mPlayers.back();
+    mPlayers[anIndex]->index = anIndex;
+    mPlayers.pop_back();
+
+    // Forget the property handles of theEntity
+    mPlayerProperties.erase(anIter);
+  }
+
+  // Forget the cached score label and render state of theEntity
+  mScoreLabels.erase(theEntity->GetID());
+  mRenderStates.erase(theEntity->GetID());
+}
+
+void LevelSystem::UpdateRenderState(GQE::IEntity* theEntity, sf::Vector2f thePosition,
+    sf::Vector2u theScreen)
+{
+  const sf::Vector2f anPosition = thePosition;
+  const sf::Vector2u anScreen = theScreen;
+
+  // Find the render state, the first position is never interpolated
+  std::map<const GQE::typeEntityID, RenderState>::iterator anIter =
+    mRenderStates.find(theEntity->GetID());
+  if(anIter == mRenderStates.end())
+  {
+    RenderState anState;
+    anState.previous = anPosition;
+    anState.current = anPosition;
+    anState.screen = anScreen;
+    anState.elapsed = 0.0f;
+    anState.interval = 0.0f;
+    anState.ticks = 0;
+    anIter = mRenderStates.insert(std::make_pair(theEntity->GetID(), anState)).first;
+  }
+  RenderState& anState = anIter->second;
+
+  // Count the fixed updates between simulated positions
+  anState.ticks++;
+
+  if(anPosition != anState.current || anScreen != anState.screen)
+  {
+    // Continue from where we are drawing now, unless we switched screens
+    anState.previous = (anScreen == anState.screen) ?
+      GetRenderPosition(theEntity) : anPosition;
+    anState.current = anPosition;
+    anState.screen = anScreen;
+
+    // Expect the next position after as many fixed updates as this one took
+    anState.interval = (float)(anState.ticks < RENDER_TICKS ? anState.ticks : RENDER_TICKS) /
+      mApp.GetUpdateRate();
+    anState.elapsed = 0.0f;
+    anState.ticks = 0;
+  }
+}
+
+sf::Vector2f LevelSystem::GetRenderPosition(GQE::IEntity* theEntity)
+{
+  // Assume theEntity has no render state yet
+  sf::Vector2f anResult = GetPlayerProperties(theEntity).position.Get();
+
+  std::map<const GQE::typeEntityID, RenderState>::iterator anIter =
+    mRenderStates.find(theEntity->GetID());
+  if(anIter != mRenderStates.end() && anIter->second.interval > 0.0f)
+  {
+    const RenderState& anState = anIter->second;
+    const float anAlpha = std::min(anState.elapsed / anState.interval, 1.0f);
+    anResult = anState.previous + (anState.current - anState.previous) * anAlpha;
+  }
+
+  // Return the position to draw theEntity at
+  return anResult;
+}
+
+LevelSystem::PlayerProperties& LevelSystem::GetPlayerProperties(GQE::IEntity* theEntity)
+{
+  // Find the property handles, resolving them the first time theEntity is used
+  std::map<const GQE::typeEntityID, PlayerProperties>::iterator anIter =
+    mPlayerProperties.find(theEntity->GetID());
+  if(anIter == mPlayerProperties.end())
+  {
+    anIter = mPlayerProperties.insert(std::make_pair(theEntity->GetID(), PlayerProperties())).first;
+    PlayerProperties& anProperties = anIter->second;
+    anProperties.entity = theEntity;
+    anProperties.index = mPlayers.size();
+    mPlayers.push_back(&anProperties);
+    anProperties.position.Resolve(theEntity, "vPosition");
+    anProperties.velocity.Resolve(theEntity, "vVelocity");
+    anProperties.screen.Resolve(theEntity, "wScreen");
+    anProperties.map.Resolve(theEntity, "wMap");
+    anProperties.boundingBox.Resolve(theEntity, "rBoundingBox");
+    anProperties.spriteRect.Resolve(theEntity, "rSpriteRect");
+    anProperties.sprite.Resolve(theEntity, "Sprite");
+    anProperties.score.Resolve(theEntity, "uScore");
+    anProperties.visible.Resolve(theEntity, "bVisible");
+    anProperties.local.Resolve(theEntity, "bNetworkLocal");
+    anProperties.loading.Resolve(theEntity, "bLoading");
+    anProperties.mapFilename.Resolve(theEntity, "sMapFilename");
+    anProperties.loadingFilename.Resolve(theEntity, "sLoadingFilename");
+  }
+
+  // Return the property handles of theEntity
+  return anIter->second;
+}
+
+LevelSystem::ScoreLabel& LevelSystem::GetScoreLabel(GQE::IEntity* theEntity,
+    GQE::Uint32 theScore)
+{
+  const GQE::Uint32 anValue = theScore;
+
+  // Find the cached label, creating it the first time theEntity is drawn
+  std::map<const GQE::typeEntityID, ScoreLabel>::iterator anIter =
+    mScoreLabels.find(theEntity->GetID());
+  if(anIter == mScoreLabels.end())
+  {
+    ScoreLabel anLabel;
+    anLabel.score = anValue + 1; // Force the label to be built below
+#if (SFML_VERSION_MAJOR < 2)
+    anLabel.text = sf::String("", mFont, (float)SCORE_SIZE);
+    anLabel.text.SetColor(sf::Color(255,255,255,255));
+#else
+    anLabel.vertices.setPrimitiveType(sf::Quads);
+#endif
+    anIter = mScoreLabels.insert(std::make_pair(theEntity->GetID(), anLabel)).first;
+  }
+  ScoreLabel& anResult = anIter->second;
+
+  // Rebuild the label only when the score has changed
+  if(anResult.score != anValue)
+  {
+    anResult.score = anValue;
+
+    // Convert score into its digits, most significant digit first
+    char anDigits[10];
+    unsigned int anCount = 0;
+    GQE::Uint32 anRemaining = anValue;
+    do
+    {
+      anDigits[anCount++] = (char)(anRemaining % 10);
+      anRemaining /= 10;
+    } while(anRemaining > 0);
+
+#if (SFML_VERSION_MAJOR < 2)
+    std::string anText;
+    while(anCount > 0)
+    {
+      anText.push_back('0' + anDigits[--anCount]);
+    }
+    anResult.text.SetText(anText);
+#else
+    // Lay out one quad per digit just like sf::Text would
+    anResult.vertices.clear();
+    float anX = 0.0f;
+    const float anY = (float)SCORE_SIZE;
+    const sf::Color anColor(255,255,255,255);
+    while(anCount > 0)
+    {
+      const sf::Glyph& anGlyph = mDigits[(unsigned int)anDigits[--anCount]];
+      const float anLeft = anX + anGlyph.bounds.left;
+      const float anTop = anY + anGlyph.bounds.top;
+      const float anRight = anLeft + anGlyph.bounds.width;
+      const float anBottom = anTop + anGlyph.bounds.height;
+      const float anU1 = (float)anGlyph.textureRect.left;
+      const float anV1 = (float)anGlyph.textureRect.top;
+      const float anU2 = (float)(anGlyph.textureRect.left + anGlyph.textureRect.width);
+      const float anV2 = (float)(anGlyph.textureRect.top + anGlyph.textureRect.height);
+      anResult.vertices.append(sf::Vertex(sf::Vector2f(anLeft, anTop), anColor, sf::Vector2f(anU1, anV1)));
+      anResult.vertices.append(sf::Vertex(sf::Vector2f(anRight, anTop), anColor, sf::Vector2f(anU2, anV1)));
+      anResult.vertices.append(sf::Vertex(sf::Vector2f(anRight, anBottom), anColor, sf::Vector2f(anU2, anV2)));
+      anResult.vertices.append(sf::Vertex(sf::Vector2f(anLeft, anBottom), anColor, sf::Vector2f(anU1, anV2)));
+      anX += (float)anGlyph.advance;
+    }
+#endif
+  }
+
+  // Return the cached label
+  return anResult;
 }
 
 /*
@@ -1007,30 +2063,63 @@ void LevelSystem::ResetProperties(bool theVisible)
 
 void LevelSystem::DropAllScreens(void)
 {
-  /*
-  std::map<const GQE::Uint32, ScreenInfo>::iterator anIter = mScreens.begin();
-  while(anIter != mScreens.end())
+  // Drop every animated tile type from our AnimationSystem
+  DropTileAnimations();
+
+  // Delete the property bag of each animated tile type
+  DropTileTypes(mTileTypes);
+#if (SFML_VERSION_MAJOR >= 2)
+
+  // Our batches and baked screens refer to the atlas of the previous map
+  mBatches.clear();
+  mAnimatedQuads.clear();
+  DropBakedScreens(true);
+  mBaked = NULL;
+#endif
+
+  // Release every screen, cell, tile list and bitmap of the map at once
+  mScreens = NULL;
+  mWalls = NULL;
+  mCollected = NULL;
+  mNumTreasures = 0;
+  mArena.Release();
+
+  // Reset our map variables
+  mScreenWidth = 0;
+  mScreenHeight = 0;
+}
+
+void LevelSystem::DropTileTypes(std::vector<TileType>& theTileTypes)
+{
+  std::vector<TileType>::iterator anIter = theTileTypes.begin();
+  while(anIter != theTileTypes.end())
   {
-    // Unload each screen in our map of all screens
-    UnloadScreen(anIter->first);
+    // Only animated tile types have a property bag to delete
+    delete anIter->entity;
 
-    // Clear the deque before moving on to the next one
-    anIter->second.clear();
+    // Don't keep addresses we have deleted around
+    anIter->entity = NULL;
 
-    // Increment our iterator to the next screen
+    // Increment tile type iterator
     anIter++;
   }
 
-  // Now clear our map of all screens
-  mScreens.clear();
+  // Swap with an empty vector so the memory is actually returned
+  std::vector<TileType>().swap(theTileTypes);
+}
 
-  // Reset our map variables
-  mScreenWidth = 0;
-  mScreenHeight = 0;
+LevelSystem::ScreenInfo* LevelSystem::GetScreen(sf::Vector2u theScreen)
+{
+  // Assume theScreen is not part of the current map
+  ScreenInfo* anResult = NULL;
 
-  // Finally reset all the Properties of each registered IEntity, set visible to false
-  //ResetProperties(false);
-  */
+  if(mScreens != NULL && theScreen.x < mScreenWidth && theScreen.y < mScreenHeight)
+  {
+    anResult = &mScreens[theScreen.x + theScreen.y*mScreenWidth];
+  }
+
+  // Return the screen found or NULL otherwise
+  return anResult;
 }
 
 void LevelSystem::LoadScreen(sf::Vector2u theScreen)
@@ -1038,65 +2127,215 @@ void LevelSystem::LoadScreen(sf::Vector2u theScreen)
   // Update our cached mScreen value to theScreen
   mScreen = theScreen;
 
-  // Get address to the new current screen
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >& anScreen =
-    mScreens[theScreen.x + theScreen.y*mScreenWidth].tiles;
+#if (SFML_VERSION_MAJOR >= 2)
+  // Build the vertex arrays of the new screen now
+  LoadTileBatches();
+#endif
+}
 
-  // Search through each z-order map to find theEntityID provided
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-  anIter = anScreen.begin();
-  while(anIter != anScreen.end())
+void LevelSystem::AddTileAnimations(void)
+{
+  // Each animated tile type has one property bag shared by all of its tiles,
+  // so its frames advance once per tick no matter how many tiles use it
+  std::vector<TileType>::iterator anIter = mTileTypes.begin();
+  while(anIter != mTileTypes.end())
   {
-    std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-    while(anQueue != anIter->second.end())
+    if(anIter->entity != NULL)
     {
-      // Get the IEntity address first
-      GQE::IEntity* anEntity = *anQueue;
+      mAnimationSystem->AddEntity(anIter->entity);
+    }
 
-      // Increment the IEntity iterator second
-      anQueue++;
+    // Increment tile type iterator
+    anIter++;
+  }
+}
 
-      // Is this an animated tile, then drop it from our AnimationSystem
-      if(anEntity->mProperties.Get<bool>("bAnimation"))
-      {
-        mAnimationSystem->AddEntity(anEntity);
-      }
-    } // while(anQueue != anIter->second.end())
+void LevelSystem::DropTileAnimations(void)
+{
+  std::vector<TileType>::iterator anIter = mTileTypes.begin();
+  while(anIter != mTileTypes.end())
+  {
+    if(anIter->entity != NULL)
+    {
+      mAnimationSystem->DropEntity(anIter->entity->GetID());
+    }
 
-    // Increment map iterator
+    // Increment tile type iterator
     anIter++;
-  } //while(anIter != mEntities.end())
+  }
 }
 
-void LevelSystem::UnloadScreen(sf::Vector2u theScreen)
+void LevelSystem::LoadThread(void* theLevelSystem)
 {
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >& anScreen =
-    mScreens[theScreen.x + theScreen.y*mScreenWidth].tiles;
+  // Perform stages 1 through 3 for theLevelSystem provided
+  static_cast<LevelSystem*>(theLevelSystem)->LoadWorker();
+}
 
-  // Search through each z-order map to find theEntityID provided
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-  anIter = anScreen.begin();
-  while(anIter != anScreen.end())
+void LevelSystem::LoadWorker(void)
+{
+  // Load the map asset now, the LevelHandler will compile it first if needed
+  mLoader->asset.LoadAsset();
+
+  // Make sure the initial loading of the map succeeded
+  if(mLoader->map.IsOpen() &&
+      mLoader->map.GetNumTilesets() > 0 &&
+      mLoader->map.GetWidth() > 0 &&
+      mLoader->map.GetHeight() > 0)
   {
-    std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-    while(anQueue != anIter->second.end())
+    // Compute some total for calculating percent complete
+    mLoader->total = mLoader->map.GetNumTilesets() +
+      mLoader->map.GetNumLayers() * mLoader->map.GetWidth() * mLoader->map.GetHeight() +
+      mLoader->map.GetNumObjects() + 1;
+
+    // Allocate the atlas that will hold every tileset image
+    mLoader->atlas = new (std::nothrow) LevelAtlas();
+
+    // No tile types have been created for any layer yet, most maps use each
+    // tile on a single layer so make room for that many up front
+    mLoader->typeIndex.assign(mLoader->map.GetNumLayers() * mLoader->map.GetNumTileTypes(), 0);
+    mLoader->tileTypes.reserve(std::min<GQE::Uint32>(mLoader->map.GetNumTileTypes(), 0xFFFF));
+
+    // Calculate the number of screens and the size of each tile
+    mLoader->screenWidth = mLoader->map.GetWidth() / mScreenTileWidth;
+    mLoader->screenHeight = mLoader->map.GetHeight() / mScreenTileHeight;
+    mLoader->tileWidth = (GQE::Uint32)(mTileScale.x * mLoader->map.GetTileWidth());
+    mLoader->tileHeight = (GQE::Uint32)(mTileScale.y * mLoader->map.GetTileHeight());
+
+    // Allocate every screen of the map from the loader arena
+    mLoader->screens = mLoader->arena.Allocate<ScreenInfo>(
+      mLoader->screenWidth * mLoader->screenHeight);
+
+    // Move on to the first stage if we have somewhere to put each screen
+    if(mLoader->screens != NULL)
     {
-      // Get the IEntity address first
-      GQE::IEntity* anEntity = *anQueue;
+      mLoader->stage = TilesetStage;
+    }
+  }
 
-      // Increment the IEntity iterator second
-      anQueue++;
+  // Perform stages 1 through 3 as fast as we can
+  bool anCancel = false;
+  while(anCancel == false && mLoader->atlas != NULL &&
+      (mLoader->stage == TilesetStage ||
+       mLoader->stage == TileStage ||
+       mLoader->stage == ObjectStage))
+  {
+    switch(mLoader->stage)
+    {
+      case TilesetStage:
+        LoadStage1();
+        break;
+      case TileStage:
+        LoadStage2();
+        break;
+      case ObjectStage:
+      default:
+        LoadStage3();
+        break;
+    }
+
+    // Publish our percent complete for DrawBar and check for cancel requests
+    sf::Lock anLock(mLoader->mutex);
+    mLoader->progress = mLoader->percent;
+    anCancel = mLoader->cancel;
+  }
+
+  // Let UpdateFixed know we are done with mLoader
+  sf::Lock anLock(mLoader->mutex);
+  mLoader->done = true;
+}
+
+void LevelSystem::LoadPublish(void)
+{
+  // Make sure a load is actually in process
+  if(mLoader != NULL)
+  {
+    // Join the loader thread, it has already finished its work
+    if(mLoader->thread != NULL)
+    {
+#if (SFML_VERSION_MAJOR < 2)
+      mLoader->thread->Wait();
+#else
+      mLoader->thread->wait();
+#endif
+      delete mLoader->thread;
+
+      // Don't keep addresses we have deleted around
+      mLoader->thread = NULL;
+    }
+
+    // Did the loader thread make it through stages 1 through 3?
+    if(mLoader->stage == WaitingStage)
+    {
+      // Unload the previous map all at once
+      DropAllScreens();
+
+      // Publish every screen and spawn position that was loaded at once
+      mArena.Swap(mLoader->arena);
+      mScreens = mLoader->screens;
+      mLoader->screens = NULL;
+      mWalls = mLoader->walls;
+      mLoader->walls = NULL;
+      mCollected = mLoader->collected;
+      mLoader->collected = NULL;
+      mNumTreasures = mLoader->treasures;
+      mMapLoads++;
+      mTileTypes.swap(mLoader->tileTypes);
+      mPositions.swap(mLoader->positions);
+
+      // Animate every animated tile type of the new map from now on
+      AddTileAnimations();
+
+      // Calculate the number of screens
+      mScreenWidth = mLoader->screenWidth;
+      mScreenHeight = mLoader->screenHeight;
+      mTileWidth = mLoader->tileWidth;
+      mTileHeight = mLoader->tileHeight;
 
-      // Is this an animated tile, then drop it from our AnimationSystem
-      if(anEntity->mProperties.Get<bool>("bAnimation"))
+      // Loop through each registered IEntity class
+      for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
       {
-        mAnimationSystem->DropEntity(anEntity->GetID());
-      }
-    } // while(anQueue != anIter->second.end())
+        // Get the IEntity address first
+        GQE::IEntity* anEntity = mPlayers[anIndex]->entity;
 
-    // Increment map iterator
-    anIter++;
-  } //while(anIter != mEntities.end())
+        // Load the map properties into each registered IEntity class
+        LoadProperties(mLoader->map, mLoader->map.GetProperties(), anEntity);
+      } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    }
+    else
+    {
+      ELOG() << "LevelSystem(" << mMapFilename << ", " << mLoadingFilename
+        << ") Error in loading LevelAsset map file!"
+        << std::endl;
+
+      // Delete the atlas and tile types that will never be used
+      delete mLoader->atlas;
+      DropTileTypes(mLoader->tileTypes);
+
+      // Keep playing the previous map under its own name
+      mMapFilename = mLoader->previousMap;
+      mLoadingFilename = mLoader->previousLoading;
+
+      // Nobody is loading anymore, or no input would ever be committed again
+      for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+      {
+        PlayerProperties& anProperties = *mPlayers[anIndex];
+        anProperties.loading.Set(false);
+
+        // Don't let ScatterMovement start the same failed load again
+        if(anProperties.local.Get())
+        {
+          anProperties.mapFilename.Set(mMapFilename);
+          anProperties.loadingFilename.Set(mLoadingFilename);
+        }
+      } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+
+      // Don't leave a failed load behind or no other map could ever be loaded
+      delete mLoader;
+
+      // Don't keep addresses we have deleted around
+      mLoader = NULL;
+    }
+  } // if(mLoader != NULL)
 }
 
 void LevelSystem::LoadStage1(void)
@@ -1110,27 +2349,34 @@ void LevelSystem::LoadStage1(void)
       // Update our loader percent complete value which ranges from 0.0 to 1.0
       mLoader->percent = (float)mLoader->tileset / mLoader->total;
 
-      // Tmx::Tileset to use for this map
-      const Tmx::Tileset* anTileset = mLoader->map.GetTileset(mLoader->tileset);
+      // LevelMap::Tileset to use for this map
+      const LevelMap::Tileset& anTileset = mLoader->map.GetTileset(mLoader->tileset);
 
-      // Tmx::Image for this Tileset
-      const Tmx::Image* anImage = anTileset->GetImage();
-
-      // Create filename for this Tmx::Image
+      // Create filename for this Tileset image
       std::string anFilename("resources/");
 
       // Append the source information provided to our filename
-      anFilename.append(anImage->GetSource());
+      anFilename.append(mLoader->map.GetString(anTileset.source));
 
-      // Add a new ImageAsset for each Tmx::Image using anFilename created above
-      mLoader->tilesets[mLoader->tileset].SetID(anFilename);
+      // Remember anFilename and colour key created above for the atlas
+      mLoader->sources.push_back(anFilename);
+      mLoader->colorKeys.push_back(anTileset.transparent);
 
       // Increment our counters for the next call to LoadStage1
       if(++mLoader->tileset == mLoader->map.GetNumTilesets())
       {
-        // Reset tileset value and proceed to LoadStage2
-        mLoader->tileset = 0;
-        mLoader->stage = TileStage;
+        // Pack every tileset image into the atlas, one texture for many tilesets
+        if(mLoader->atlas->Create(mMapFilename, mLoader->sources, mLoader->colorKeys))
+        {
+          // Reset tileset value and proceed to LoadStage2
+          mLoader->tileset = 0;
+          mLoader->stage = TileStage;
+        }
+        else
+        {
+          // Without the atlas no tile can be drawn, give up on this map
+          mLoader->stage = UnknownStage;
+        }
       }
     }
     else
@@ -1150,136 +2396,231 @@ void LevelSystem::LoadStage2(void)
     if(mLoader->map.GetNumLayers() > 0)
     {
       // Update our loader percent complete value which ranges from 0.0 to 1.0
-      mLoader->percent = (float)(mLoader->layer * mLoader->map.GetWidth() * mLoader->map.GetHeight() +
-          mLoader->x * mLoader->map.GetHeight() + mLoader->y) / mLoader->total;
+      mLoader->percent = (float)(mLoader->map.GetNumTilesets() +
+          mLoader->layer * mLoader->map.GetWidth() * mLoader->map.GetHeight() +
+          mLoader->y * mLoader->map.GetWidth() + mLoader->x) / mLoader->total;
 
-      // Tmx::Layer pointer constant for the current layer
-      const Tmx::Layer* anLayer = mLoader->map.GetLayer(mLoader->layer);
+      // Cell at the x and y coordinate specified
+      const GQE::Uint16 anCell = mLoader->map.GetCells(mLoader->layer)[
+        mLoader->y * mLoader->map.GetWidth() + mLoader->x];
 
-      // Tmx::MapTile at the x and y coordinate specified
-      const Tmx::MapTile anMapTile = anLayer->GetTile(mLoader->x, mLoader->y);
+      // Screen at the x and y coordinate specified, partial screens are skipped
+      const sf::Vector2u anScreen(mLoader->x / mScreenTileWidth,
+        mLoader->y / mScreenTileHeight);
 
-      // If tilesetId is not >= 0 then it is an empty tile, move on
-      if(anMapTile.tilesetId >= 0)
+      // If the cell is 0 then it is an empty tile, move on
+      if(anCell > 0 &&
+          anScreen.x < mLoader->screenWidth && anScreen.y < mLoader->screenHeight)
       {
-        // Tmx::Tileset to use for this tile
-        const Tmx::Tileset *anTileset = mLoader->map.GetTileset(anMapTile.tilesetId);
+        // Find the TileType for this tile on this layer, create it the first time
+        GQE::Uint16& anType = mLoader->typeIndex[
+          mLoader->layer * mLoader->map.GetNumTileTypes() + (anCell - 1)];
+        if(anType == 0)
+        {
+          anType = LoadTileType(mLoader->layer, anCell - 1);
+        }
 
-        // Create a GQE::Instance to represent this tile
-        GQE::Instance* anInstance = mTile.MakeInstance();
+        ScreenInfo& anInfo = mLoader->screens[anScreen.x + anScreen.y * mLoader->screenWidth];
 
-        if(anInstance != NULL)
+        // Allocate the cells of every layer the first time we see this screen
+        if(anType > 0 && anInfo.cells == NULL)
         {
-          const GQE::Uint32 anScreen = (mLoader->x / mScreenTileWidth) +
-            ((mLoader->y / mScreenTileHeight) * mScreenWidth);
-
-          // Set our z-order to the same as our layer
-          anInstance->SetOrder(mLoader->layer);
-
-          // Add this instance to our queue for this screen
-          mScreens[anScreen].tiles[mLoader->layer].push_back(anInstance);
-
-          // Add the tile ID as a special property of anInstance
-          anInstance->mProperties.Add<GQE::Uint32>("uTileID", anMapTile.id);
-
-          // Add the map position and screen relative position for this tile as properties
-          // This is the tile in Map coordinates
-          anInstance->mProperties.Add<sf::Vector2u>("wMap",
-            sf::Vector2u(mLoader->x, mLoader->y));
-
-          // This is the screen that the tile will display on
-          anInstance->mProperties.Add<sf::Vector2u>("wScreen",
-            sf::Vector2u(mLoader->x / mScreenTileWidth, mLoader->y / mScreenTileHeight));
+          anInfo.cells = mLoader->arena.Allocate<TileCell>(
+            mLoader->map.GetNumLayers() * mScreenTileWidth * mScreenTileHeight);
+          anInfo.layers = (anInfo.cells != NULL) ? mLoader->map.GetNumLayers() : 0;
+        }
 
-          anInstance->mProperties.Add<bool>("bAnimation", false);
-          anInstance->mProperties.Add<bool>("bTreasure", false);
-          anInstance->mProperties.Add<bool>("bWall", false);
+        if(anType > 0 && anInfo.cells != NULL)
+        {
+          // Fill in the cell for this tile, the lists are made by LoadTileLists
+          TileCell& anTileCell = anInfo.cells[
+            mLoader->layer * mScreenTileWidth * mScreenTileHeight +
+            (mLoader->y % mScreenTileHeight) * mScreenTileWidth +
+            (mLoader->x % mScreenTileWidth)];
+          anTileCell.type = anType;
+          anTileCell.flags = TILE_VISIBLE | mLoader->tileTypes[anType - 1].flags;
+        } // if(anType > 0 && anInfo.cells != NULL)
+      } // if(anCell > 0 && ...)
+
+      // Increment our counters for the next call to LoadStage2, row by row
+      // to match the order of the cells in the compiled level file
+      if(++mLoader->x == mLoader->map.GetWidth())
+      {
+        // Reset x value and increment y value
+        mLoader->x = 0;
+        if(++mLoader->y == mLoader->map.GetHeight())
+        {
+          // Reset y value and increment layer value
+          mLoader->y = 0;
+          if(++mLoader->layer == mLoader->map.GetNumLayers())
+          {
+            // Every tile type is loaded, the atlas images were only needed
+            // to find the opaque tile types
+            mLoader->atlas->DropImages();
 
-          // Load a texture into our Sprite for this tile
-          anInstance->mProperties.Set<sf::Sprite>("Sprite",
-              sf::Sprite(mLoader->tilesets[anMapTile.tilesetId].GetAsset()));
+            // Every cell is loaded, make the tile lists of each screen
+            LoadTileLists();
 
-#if SFML_VERSION_MAJOR<2
-          const sf::Uint32 anWidth = mLoader->tilesets[anMapTile.tilesetId].GetAsset().GetWidth();
-          if(anWidth > 0)
-          {
-            anInstance->mProperties.Set<sf::IntRect>("rSpriteRect",
-                sf::IntRect(
-                  (anMapTile.id%int(anWidth/mLoader->map.GetTileWidth()))*mLoader->map.GetTileWidth(),
-                  (anMapTile.id/int(anWidth/mLoader->map.GetTileHeight()))*mLoader->map.GetTileHeight(),
-                  (anMapTile.id%int(anWidth/mLoader->map.GetTileWidth()))*mLoader->map.GetTileWidth()+mTileWidth,
-                  (anMapTile.id/int(anWidth/mLoader->map.GetTileHeight()))*mLoader->map.GetTileHeight()+mTileHeight));
-          }
-          //anInstance->mProperties.Set<sf::IntRect>("rBoundingBox",
-          //    sf::IntRect(1,1,mLoader->map.GetTileWidth(),mLoader->map.GetTileHeight()));
-#else
-          const sf::Vector2u anSize = mLoader->tilesets[anMapTile.tilesetId].GetAsset().getSize();
-          if(anSize.x > 0)
-          {
-            anInstance->mProperties.Set<sf::IntRect>("rSpriteRect",
-                sf::IntRect(anMapTile.id%int(anSize.x/mLoader->map.GetTileWidth())*mLoader->map.GetTileWidth(),
-                  anMapTile.id/int(anSize.x/mLoader->map.GetTileHeight())*mLoader->map.GetTileHeight(),
-                  mLoader->map.GetTileWidth(),mLoader->map.GetTileHeight()));
+            // Reset layer value and proceed to LoadStage4
+            mLoader->layer = 0;
+            mLoader->stage = ObjectStage;
           }
-          //anInstance->mProperties.Set<sf::IntRect>("rBoundingBox",
-          //    sf::IntRect(1,1,mLoader->map.GetTileWidth()-1,mLoader->map.GetTileHeight()-1));
-#endif
-          // Set the position for this tile
-          anInstance->mProperties.Set<sf::Vector2f>("vPosition",
-              sf::Vector2f((float)(mLoader->x % mScreenTileWidth)*mTileWidth,
-                (float)(mLoader->y % mScreenTileHeight)*mTileHeight));
+        }
+      }
+    }
+    else
+    {
+      // Move on to next stage, no layers available
+      mLoader->stage = ObjectStage;
+    }
+  } // if(mLoader != NULL)
+}
 
-          // First load the Layer properties into this tile
-          LoadProperties(anLayer->GetProperties().GetList(), anInstance);
+void LevelSystem::LoadTileLists(void)
+{
+  const GQE::Uint32 anScreenTiles = mScreenTileWidth * mScreenTileHeight;
+  const GQE::Uint32 anScreens = mLoader->screenWidth * mLoader->screenHeight;
+  const GQE::Uint32 anMapWidth = mLoader->screenWidth * mScreenTileWidth;
+
+  // One wall bit for every cell of the map, which starts out zero filled
+  mLoader->walls = mLoader->arena.Allocate<GQE::Uint32>(
+    (anMapWidth * mLoader->screenHeight * mScreenTileHeight + 31) / 32);
+  if(mLoader->walls == NULL)
+  {
+    ELOG() << "LevelSystem::LoadTileLists() Unable to allocate wall bitmap!" << std::endl;
+  }
 
-          // Tmx::Tile type for the given Map Tile ID value
-          const Tmx::Tile *anTile = anTileset->GetTile(anMapTile.id);
+  // Animated tile types found on each screen, reused for every screen
+  std::vector<GQE::Uint16> anAnimations;
 
-          // Now override any layer properties with specific tile properties
-          if(anTile != NULL)
-          {
-            // Load the tile properties into anInstance
-            LoadProperties(anTile->GetProperties().GetList(), anInstance);
-          }
+  // Visible and hidden tiles of the whole map for our overdraw report
+  GQE::Uint32 anMapTiles = 0;
+  GQE::Uint32 anMapHidden = 0;
 
-          // Is this a treasure tile, then add it to our list of treasures
-          if(anInstance->mProperties.Get<bool>("bTreasure"))
+  for(GQE::Uint32 anScreen = 0; anScreen < anScreens; anScreen++)
+  {
+    ScreenInfo& anInfo = mLoader->screens[anScreen];
+    const GQE::Uint32 anCells = anInfo.layers * anScreenTiles;
+
+    // The map cell of the top left corner of this screen
+    const GQE::Uint32 anLeft = (anScreen % mLoader->screenWidth) * mScreenTileWidth;
+    const GQE::Uint32 anTop = (anScreen / mLoader->screenWidth) * mScreenTileHeight;
+
+    // Hide every tile under an opaque tile of a higher layer, working down
+    // from the top layer of each cell
+    GQE::Uint32 anTiles = 0;
+    GQE::Uint32 anHidden = 0;
+    for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles && anInfo.cells != NULL; anIndex++)
+    {
+      bool anCovered = false;
+      for(GQE::Uint32 anLayer = anInfo.layers; anLayer > 0; anLayer--)
+      {
+        TileCell& anCell = anInfo.cells[(anLayer - 1) * anScreenTiles + anIndex];
+        if(anCell.type > 0 && (anCell.flags & TILE_VISIBLE))
+        {
+          anTiles++;
+          if(anCovered)
           {
-            mScreens[anScreen].treasures.push_back(anInstance);
+            anCell.flags |= TILE_HIDDEN;
+            anHidden++;
           }
-
-          // Is this a wall, then add it to our list of walls
-          if(anInstance->mProperties.Get<bool>("bWall"))
+          else if(anCell.flags & TILE_OPAQUE)
           {
-            mScreens[anScreen].walls.push_back(anInstance);
+            anCovered = true;
           }
-        } // if(anInstance != NULL)
-      } // if(anMapTile.tilesetId>=0)
+        }
+      }
+    }
+    if(anTiles > 0)
+    {
+      ILOG() << "LevelSystem::LoadTileLists() Screen(" << anLeft / mScreenTileWidth << ", "
+        << anTop / mScreenTileHeight << ") hides " << anHidden << " of " << anTiles
+        << " tiles" << std::endl;
+    }
+    anMapTiles += anTiles;
+    anMapHidden += anHidden;
+
+    // First count the treasures, mark the walls and find each animated tile
+    // type, the layers below the first treasure or animated tile never change
+    anAnimations.clear();
+    anInfo.staticLayers = anInfo.layers;
+    for(GQE::Uint32 anIndex = 0; anIndex < anCells; anIndex++)
+    {
+      const TileCell& anCell = anInfo.cells[anIndex];
+      if((anCell.flags & (TILE_TREASURE | TILE_ANIMATION)) &&
+          anIndex / anScreenTiles < anInfo.staticLayers)
+      {
+        anInfo.staticLayers = anIndex / anScreenTiles;
+      }
+      if((anCell.flags & TILE_WALL) && (anCell.flags & TILE_VISIBLE) && mLoader->walls != NULL)
+      {
+        const GQE::Uint32 anBit = (anTop + (anIndex % anScreenTiles) / mScreenTileWidth) *
+          anMapWidth + anLeft + (anIndex % anScreenTiles) % mScreenTileWidth;
+        mLoader->walls[anBit / 32] |= (1U << (anBit % 32));
+      }
+      if(anCell.flags & TILE_TREASURE)
+      {
+        anInfo.numTreasures++;
+      }
+      if((anCell.flags & TILE_ANIMATION) &&
+          std::find(anAnimations.begin(), anAnimations.end(),
+            (GQE::Uint16)(anCell.type - 1)) == anAnimations.end())
+      {
+        anAnimations.push_back((GQE::Uint16)(anCell.type - 1));
+      }
+    }
 
-      // Increment our counters for the next call to LoadStage3
-      if(++mLoader->y == mLoader->map.GetHeight())
+    // Now allocate each list from the loader arena
+    anInfo.treasures = mLoader->arena.Allocate<TileRef>(anInfo.numTreasures);
+    anInfo.treasureCells = mLoader->arena.Allocate<GQE::Uint16>(anScreenTiles);
+    anInfo.animations = mLoader->arena.Allocate<GQE::Uint16>(anAnimations.size());
+    if(anInfo.treasures != NULL && anInfo.treasureCells != NULL && anInfo.animations != NULL)
+    {
+      // Finally fill in the treasure list in cell and layer order, so each
+      // cell only needs to remember its first treasure
+      GQE::Uint32 anTreasure = 0;
+      for(GQE::Uint32 anIndex = 0; anIndex < anScreenTiles; anIndex++)
       {
-        // Reset y value and increment x value
-        mLoader->y = 0;
-        if(++mLoader->x == mLoader->map.GetWidth())
+        for(GQE::Uint32 anLayer = 0; anLayer < anInfo.layers; anLayer++)
         {
-          // Reset x value and increment layer value
-          mLoader->x = 0;
-          if(++mLoader->layer == mLoader->map.GetNumLayers())
+          if(anInfo.cells[anLayer * anScreenTiles + anIndex].flags & TILE_TREASURE)
           {
-            // Reset layer value and proceed to LoadStage4
-            mLoader->layer = 0;
-            mLoader->stage = ObjectStage;
+            if(anInfo.treasureCells[anIndex] == 0)
+            {
+              anInfo.treasureCells[anIndex] = (GQE::Uint16)(anTreasure + 1);
+            }
+            anInfo.treasures[anTreasure].layer = (GQE::Uint16)anLayer;
+            anInfo.treasures[anTreasure].cell = (GQE::Uint16)anIndex;
+            anTreasure++;
           }
         }
       }
+
+      // Each treasure of the map gets its own bit in the collected bitset
+      anInfo.firstTreasure = mLoader->treasures;
+      mLoader->treasures += anInfo.numTreasures;
+      std::copy(anAnimations.begin(), anAnimations.end(), anInfo.animations);
+      anInfo.numAnimations = (GQE::Uint32)anAnimations.size();
     }
     else
     {
-      // Move on to next stage, no layers available
-      mLoader->stage = ObjectStage;
+      ELOG() << "LevelSystem::LoadTileLists() Unable to allocate tile lists!" << std::endl;
+
+      // Keep going without any lists for this screen
+      anInfo.treasureCells = NULL;
+      anInfo.numTreasures = 0;
     }
-  } // if(mLoader != NULL)
+  }
+
+  ILOG() << "LevelSystem::LoadTileLists() Map hides " << anMapHidden << " of "
+    << anMapTiles << " tiles" << std::endl;
+
+  // Every treasure starts out not collected
+  mLoader->collected = mLoader->arena.Allocate<GQE::Uint32>((mLoader->treasures + 31) / 32);
+  if(mLoader->collected == NULL)
+  {
+    ELOG() << "LevelSystem::LoadTileLists() Unable to allocate collected bitset!" << std::endl;
+  }
 }
 
 void LevelSystem::LoadStage3(void)
@@ -1288,44 +2629,208 @@ void LevelSystem::LoadStage3(void)
   if(mLoader != NULL)
   {
     // Sanity check our boundaries
-    if(mLoader->map.GetNumObjectGroups() > 0)
+    if(mLoader->map.GetNumObjects() > 0)
     {
       // Update our loader percent complete value which ranges from 0.0 to 1.0
-      mLoader->percent = (float)mLoader->group / mLoader->map.GetNumObjectGroups();
+      mLoader->percent = (float)(mLoader->map.GetNumTilesets() +
+          mLoader->map.GetNumLayers() * mLoader->map.GetWidth() * mLoader->map.GetHeight() +
+          mLoader->object) / mLoader->total;
 
-      // The Tmx::ObjectGroup to look through
-      const Tmx::ObjectGroup* anObjectGroup = mLoader->map.GetObjectGroup(mLoader->group);
+      // The LevelMap::Object to look at, objects from every group are flattened
+      const LevelMap::Object& anObject = mLoader->map.GetObject(mLoader->object);
 
-      // The Tmx::Object in the current ObjectGroup
-      const Tmx::Object* anObject = anObjectGroup->GetObject(mLoader->object);
-
-      if(anObject->GetName()=="Start")
+      if(std::strcmp(mLoader->map.GetString(anObject.name), "Start") == 0)
       {
         // Push the starting position into our vector of positions
-        mPositions.push_back(sf::Vector2f((float)anObject->GetX(), (float)anObject->GetY()));
+        mLoader->positions.push_back(sf::Vector2f((float)anObject.x, (float)anObject.y));
       }
 
       // Increment our counters for the next call to LoadStage4
-      if(++mLoader->object == anObjectGroup->GetNumObjects())
+      if(++mLoader->object == mLoader->map.GetNumObjects())
       {
-        // Reset object value and increment group value
+        // Reset object value and proceed to LoadStage4
         mLoader->object = 0;
-        if(++mLoader->group == mLoader->map.GetNumObjectGroups())
-        {
-          // Reset group value and proceed to LoadStage5
-          mLoader->group = 0;
-          mLoader->stage = WaitingStage;
-        }
+        mLoader->stage = WaitingStage;
       }
     }
     else
     {
-      // Move on to next stage, no object groups available
+      // Move on to next stage, no objects available
       mLoader->stage = WaitingStage;
     }
   } // if(mLoader != NULL)
 }
 
+GQE::Uint16 LevelSystem::LoadTileType(GQE::Uint32 theLayer, GQE::Uint32 theType)
+{
+  // Assume no TileType will be created
+  GQE::Uint16 anResult = 0;
+
+  if(mLoader->tileTypes.size() < 0xFFFF)
+  {
+    // LevelMap::TileType and LevelMap::Layer to use for this tile
+    const LevelMap::TileType& anTileType = mLoader->map.GetTileType(theType);
+    const LevelMap::Layer& anLayer = mLoader->map.GetLayer(theLayer);
+
+    // The typed tile properties shared by every tile with the same property sets
+    const TileSchema& anSchema = LoadSchema(anLayer.properties, anTileType.properties);
+
+    // The sprite rect was already computed when the level was compiled
+#if SFML_VERSION_MAJOR<2
+    const sf::IntRect anRect(anTileType.rect[0], anTileType.rect[1],
+        anTileType.rect[0] + anTileType.rect[2],
+        anTileType.rect[1] + anTileType.rect[3]);
+#else
+    const sf::IntRect anRect(anTileType.rect[0], anTileType.rect[1],
+        anTileType.rect[2], anTileType.rect[3]);
+#endif
+
+    // Where the tileset of this tile was placed in the atlas
+    const LevelAtlas::Placement& anPlacement =
+      mLoader->atlas->GetPlacement(anTileType.tileset);
+
+    // Create the shared TileType from the typed properties above
+    TileType anType;
+    anType.offset = sf::Vector2i((int)anPlacement.x, (int)anPlacement.y);
+    anType.sprite = sf::Sprite(mLoader->atlas->GetPage(anPlacement.page));
+#if SFML_VERSION_MAJOR<2
+    sf::IntRect anAtlasRect(anRect);
+    anAtlasRect.Offset(anType.offset.x, anType.offset.y);
+    anType.sprite.SetSubRect(anAtlasRect);
+#else
+    anType.sprite.setTextureRect(sf::IntRect(anRect.left + anType.offset.x,
+        anRect.top + anType.offset.y, anRect.width, anRect.height));
+#endif
+    anType.value = anSchema.value;
+    anType.flags = anSchema.flags;
+    anType.entity = NULL;
+
+    // Only animated tile types need a property bag for our AnimationSystem
+    if(anType.flags & TILE_ANIMATION)
+    {
+      GQE::Instance* anInstance = mTile.MakeInstance();
+      if(anInstance != NULL)
+      {
+        // Set our z-order to the same as our layer
+        anInstance->SetOrder(theLayer);
+
+        // Add the tile ID as a special property of anInstance
+        anInstance->mProperties.Add<GQE::Uint32>("uTileID", anTileType.id);
+        anInstance->mProperties.Set<sf::IntRect>("rSpriteRect", anRect);
+
+        // First load the Layer properties into this tile type
+        LoadProperties(mLoader->map, anLayer.properties, anInstance);
+
+        // Now override any layer properties with specific tile properties
+        LoadProperties(mLoader->map, anTileType.properties, anInstance);
+
+        anType.entity = anInstance;
+      }
+      else
+      {
+        // Without a property bag this tile type can't be animated
+        anType.flags &= ~TILE_ANIMATION;
+      }
+    }
+
+    // Tiles that never change and cover their cell with opaque pixels hide
+    // the tiles of every layer below them, the tileset rect is in source
+    // pixels so compare it against the unscaled map tile size
+    const GQE::Uint32 anCellWidth = mLoader->map.GetTileWidth();
+    const GQE::Uint32 anCellHeight = mLoader->map.GetTileHeight();
+    if((anType.flags & (TILE_ANIMATION | TILE_TREASURE)) == 0 &&
+        anTileType.rect[2] >= (GQE::Int32)anCellWidth &&
+        anTileType.rect[3] >= (GQE::Int32)anCellHeight &&
+        mLoader->atlas->IsOpaque(anTileType.tileset, anTileType.rect[0], anTileType.rect[1],
+          anCellWidth, anCellHeight))
+    {
+      anType.flags |= TILE_OPAQUE;
+    }
+
+    // Add the new TileType and return its index plus one
+    mLoader->tileTypes.push_back(anType);
+    anResult = (GQE::Uint16)mLoader->tileTypes.size();
+  }
+  else
+  {
+    ELOG() << "LevelSystem::LoadTileType(" << theLayer << ", " << theType
+      << ") Too many tile types!" << std::endl;
+  }
+
+  // Return the index plus one of the new TileType or 0 if none was created
+  return anResult;
+}
+
+const LevelSystem::TileSchema& LevelSystem::LoadSchema(
+    const LevelMap::Range theLayer, const LevelMap::Range theTile)
+{
+  // Identical property sets share the same range in the compiled level file,
+  // so the start of each non empty range identifies its property set
+  const typeSchemaKey anKey(
+    theLayer.count > 0 ? theLayer.first + 1 : 0,
+    theTile.count > 0 ? theTile.first + 1 : 0);
+
+  // Have we already looked at this pair of property sets?
+  std::map<typeSchemaKey, TileSchema>::iterator anIter = mLoader->schemas.find(anKey);
+  if(anIter == mLoader->schemas.end())
+  {
+    TileSchema anSchema;
+    anSchema.value = 0;
+    anSchema.flags = 0;
+
+    // Look at the layer properties first and then let the tile properties
+    // override them, just like LoadProperties would
+    const LevelMap::Range anRanges[2] = {theLayer, theTile};
+    for(int anSet = 0; anSet < 2; anSet++)
+    {
+      for(GQE::Uint32 i = anRanges[anSet].first;
+          i < anRanges[anSet].first + anRanges[anSet].count; i++)
+      {
+        const LevelMap::Property& anProperty = mLoader->map.GetProperty(i);
+        const char* anName = mLoader->map.GetString(anProperty.name);
+        GQE::Uint8 anFlag = 0;
+
+        if(anProperty.type == LevelMap::PropertyUint32 &&
+            std::strcmp(anName, "uValue") == 0)
+        {
+          anSchema.value = anProperty.value.u[0];
+        }
+        else if(anProperty.type == LevelMap::PropertyBool)
+        {
+          if(std::strcmp(anName, "bWall") == 0)
+          {
+            anFlag = TILE_WALL;
+          }
+          else if(std::strcmp(anName, "bTreasure") == 0)
+          {
+            anFlag = TILE_TREASURE;
+          }
+          else if(std::strcmp(anName, "bAnimation") == 0)
+          {
+            anFlag = TILE_ANIMATION;
+          }
+
+          // Set or clear the flag according to the property value
+          if(anProperty.value.u[0] != 0)
+          {
+            anSchema.flags |= anFlag;
+          }
+          else
+          {
+            anSchema.flags &= ~anFlag;
+          }
+        }
+      }
+    }
+
+    // Remember the typed properties for this pair of property sets
+    anIter = mLoader->schemas.insert(std::make_pair(anKey, anSchema)).first;
+  }
+
+  // Return the cached TileSchema
+  return anIter->second;
+}
+
 void LevelSystem::LoadStage4(void)
 {
   // How many players have committed keyboard state information?
@@ -1339,59 +2844,47 @@ void LevelSystem::LoadStage4(void)
     //ResetProperties(true);
 
     // Clear our bLoading flag for each player
-    std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      // Get the property handles of this player
+      PlayerProperties& anProperties = *mPlayers[anIndex];
+
+      // Player is local
+      if(anProperties.local.Get())
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
+        // Select a random position for this player
+        unsigned int anSpawn = rand()%mPositions.size();
+        const sf::Vector2u anScreen(
+          (unsigned int)mPositions[anSpawn].x / (mScreenTileWidth*mTileWidth),
+          (unsigned int)mPositions[anSpawn].y / (mScreenTileHeight*mTileHeight));
+        const sf::Vector2f anPosition(
+          (float)((int)mPositions[anSpawn].x % (mScreenTileWidth*mTileWidth)),
+          (float)((int)mPositions[anSpawn].y % (mScreenTileHeight*mTileHeight)));
 
-        // Increment the IEntity iterator second
-        anQueue++;
+        // Set our LevelSystem properties
+        anProperties.loadingFilename.Set(mLoadingFilename);
+        anProperties.mapFilename.Set(mMapFilename);
+        
+        // Set our wScreen property value for this player
+        anProperties.screen.Set(anScreen);
 
-        // Player is local
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
-        {
-          // Select a random position for this player
-          unsigned int anIndex = rand()%mPositions.size();
-          const sf::Vector2u anScreen(
-            (unsigned int)mPositions[anIndex].x / (mScreenTileWidth*mTileWidth),
-            (unsigned int)mPositions[anIndex].y / (mScreenTileHeight*mTileHeight));
-          const sf::Vector2f anPosition(
-            (float)((int)mPositions[anIndex].x % (mScreenTileWidth*mTileWidth)),
-            (float)((int)mPositions[anIndex].y % (mScreenTileHeight*mTileHeight)));
-
-          // Set our LevelSystem properties
-          anEntity->mProperties.Set<std::string>("sLoadingFilename", mLoadingFilename);
-          anEntity->mProperties.Set<std::string>("sMapFilename", mMapFilename);
-          
-          // Set our wScreen property value for this player
-          anEntity->mProperties.Set<sf::Vector2u>("wScreen", anScreen);
-
-          // Set our vPosition property value for this player
-          anEntity->mProperties.Set<sf::Vector2f>("vPosition", anPosition);
-
-          // Set our bLoading property to false
-          anEntity->mProperties.Set<bool>("bLoading", false);
-        }
+        // Set our vPosition property value for this player
+        anProperties.position.Set(anPosition);
 
-        // Has this player finished loading their level?
-        if(anEntity->mProperties.Get<bool>("bLoading") == false)
-        {
-          // Increment our committed count number
-          anCount++;
-        }
+        // Set our bLoading property to false
+        anProperties.loading.Set(false);
+      }
 
-        // Increment our total committed members count
-        anTotal++;
-      } // while(anQueue != anIter->second.end())
+      // Has this player finished loading their level?
+      if(anProperties.loading.Get() == false)
+      {
+        // Increment our committed count number
+        anCount++;
+      }
 
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
+      // Increment our total committed members count
+      anTotal++;
+    } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 
     if(anCount == anTotal)
     {
@@ -1410,51 +2903,34 @@ void LevelSystem::LoadStage5(void)
   // Make sure a load is actually in process
   if(mLoader != NULL)
   {
-    // Did we have a previous tileset in use? then delete it now
-    if(mTilesets != NULL)
-    {
-      // By deleting it here we can refrain from reloading identical tilesets
-      // already in memory
-      delete[] mTilesets;
-    }
+    // Did we have a previous atlas in use? then delete it now, the tile
+    // types using it were already dropped when the new map was published
+    delete mAtlas;
 
-    // Make note of the new mTilesets
-    mTilesets = mLoader->tilesets;
+    // Make note of the new mAtlas
+    mAtlas = mLoader->atlas;
 
     // Reset all our registered IEntity properties
     //ResetProperties(true);
 
     // Make each player visible now
-    std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
-      {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
-
-        // Increment the IEntity iterator second
-        anQueue++;
-
-        // Player is local
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
-        {
-          // Make our player visible
-          anEntity->mProperties.Set<bool>("bVisible", true);
-        }
-        else
-        {
-          // Network players should disappear if they are not on the same screen as local players
-          sf::Vector2u anScreen = anEntity->mProperties.Get<sf::Vector2u>("wScreen");
-          anEntity->mProperties.Set<bool>("bVisible", (anScreen == mScreen));
-        }
-      } // while(anQueue != anIter->second.end())
+      // Get the property handles of this player
+      PlayerProperties& anProperties = *mPlayers[anIndex];
 
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
+      // Player is local
+      if(anProperties.local.Get())
+      {
+        // Make our player visible
+        anProperties.visible.Set(true);
+      }
+      else
+      {
+        // Network players should disappear if they are not on the same screen as local players
+        anProperties.visible.Set(anProperties.screen.Get() == mScreen);
+      }
+    } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 
     // Now remove our mLoader value since we are finally done
     delete mLoader;
@@ -1464,216 +2940,165 @@ void LevelSystem::LoadStage5(void)
   } // if(mLoader != NULL)
 }
 
-void LevelSystem::LoadProperties(std::map<std::string, std::string> theProperties,
-    GQE::IEntity* theEntity)
+void LevelSystem::LoadProperties(const LevelMap& theMap,
+    const LevelMap::Range theProperties, GQE::IEntity* theEntity)
 {
-  if(theEntity != NULL && theProperties.empty() == false)
+  if(theEntity != NULL && theProperties.count > 0)
   {
-    // Loop through each property and add them as a number, boolean, or string
-    std::map<std::string, std::string>::iterator anIter = theProperties.begin();
-    while(anIter != theProperties.end())
+    // Loop through each property and add them using the type chosen when compiled
+    for(GQE::Uint32 i = theProperties.first; i < theProperties.first + theProperties.count; i++)
     {
-      // Is this a boolean property value? then its name will start with b or B
-      if(anIter->first.at(0) == 'b' || anIter->first.at(0) == 'B')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          bool anPrevious = theEntity->mProperties.Get<bool>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<bool>(anIter->first,
-              GQE::ParseBool(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<bool>(anIter->first,
-              GQE::ParseBool(anIter->second, false));
-        }
-      }
-      // Is this a color value? then its name will start with c or C
-      else if(anIter->first.at(0) == 'c' || anIter->first.at(0) == 'C')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          sf::Color anPrevious = theEntity->mProperties.Get<sf::Color>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<sf::Color>(anIter->first,
-              GQE::ParseColor(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a sf::Color property value
-          theEntity->mProperties.Add<sf::Color>(anIter->first,
-              GQE::ParseColor(anIter->second, sf::Color(0,0,0,0)));
-        }
-      }
-      // Is this a float value? then its name will start with f or F
-      else if(anIter->first.at(0) == 'f' || anIter->first.at(0) == 'F')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          float anPrevious = theEntity->mProperties.Get<float>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<float>(anIter->first,
-              GQE::ParseFloat(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a float property value
-          theEntity->mProperties.Add<float>(anIter->first,
-              GQE::ParseFloat(anIter->second, 0.0f));
-        }
-      }
-      // Is this a signed numeric property value? then its name will start with i or I
-      else if(anIter->first.at(0) == 'i' || anIter->first.at(0) == 'I')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          GQE::Int32 anPrevious = theEntity->mProperties.Get<GQE::Int32>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<GQE::Int32>(anIter->first,
-              GQE::ParseInt32(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<GQE::Int32>(anIter->first,
-              GQE::ParseInt32(anIter->second, 0));
-        }
-      }
-      // Is this an sf::IntRect property value? then its name will start with r or R
-      if(anIter->first.at(0) == 'r' || anIter->first.at(0) == 'R')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          sf::IntRect anPrevious = theEntity->mProperties.Get<sf::IntRect>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<sf::IntRect>(anIter->first,
-              GQE::ParseIntRect(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<sf::IntRect>(anIter->first,
-              GQE::ParseIntRect(anIter->second, sf::IntRect(0,0,0,0)));
-        }
-      }
-      // Is this an unsigned numeric property value? then its name will start with u or U
-      if(anIter->first.at(0) == 'u' || anIter->first.at(0) == 'U')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          GQE::Uint32 anPrevious = theEntity->mProperties.Get<GQE::Uint32>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<GQE::Uint32>(anIter->first,
-              GQE::ParseUint32(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<GQE::Uint32>(anIter->first,
-              GQE::ParseUint32(anIter->second, 0));
-        }
-      }
-      // Is this a sf::Vector2f property value? then its name will start with v or V
-      if(anIter->first.at(0) == 'v' || anIter->first.at(0) == 'V')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          sf::Vector2f anPrevious = theEntity->mProperties.Get<sf::Vector2f>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<sf::Vector2f>(anIter->first,
-              GQE::ParseVector2f(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<sf::Vector2f>(anIter->first,
-              GQE::ParseVector2f(anIter->second, sf::Vector2f(0.0f,0.0f)));
-        }
-      }
-      // Is this a sf::Vector2u property value? then its name will start with w or W
-      if(anIter->first.at(0) == 'w' || anIter->first.at(0) == 'W')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          sf::Vector2u anPrevious = theEntity->mProperties.Get<sf::Vector2u>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<sf::Vector2u>(anIter->first,
-              GQE::ParseVector2u(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<sf::Vector2u>(anIter->first,
-              GQE::ParseVector2u(anIter->second, sf::Vector2u(0,0)));
-        }
-      }
-      // Is this a sf::Vector3f property value? then its name will start with z or Z
-      if(anIter->first.at(0) == 'z' || anIter->first.at(0) == 'Z')
-      {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Get the previous value and use it as the default
-          sf::Vector3f anPrevious = theEntity->mProperties.Get<sf::Vector3f>(anIter->first);
-          // Now set the new value by parsing the string provided
-          theEntity->mProperties.Set<sf::Vector3f>(anIter->first,
-              GQE::ParseVector3f(anIter->second, anPrevious));
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<sf::Vector3f>(anIter->first,
-              GQE::ParseVector3f(anIter->second, sf::Vector3f(0.0f,0.0f,0.0f)));
-        }
-      }
-      // Otherwise assume its a string property
-      else
+      const LevelMap::Property& anProperty = theMap.GetProperty(i);
+      const GQE::typePropertyID anName(theMap.GetString(anProperty.name));
+
+      switch(anProperty.type)
       {
-        // If the property already exists then replace it by setting a new property value
-        if(theEntity->mProperties.HasID(anIter->first))
-        {
-          // Set the new value as the string value provided
-          theEntity->mProperties.Set<std::string>(anIter->first, anIter->second);
-        }
-        // Otherwise just add the new property value
-        else
-        {
-          // Create a boolean property by associating 0 as a false value, otherwise true
-          theEntity->mProperties.Add<std::string>(anIter->first, anIter->second);
-        }
+        // Is this a boolean property value? then its name started with b or B
+        case LevelMap::PropertyBool:
+          {
+            bool anValue = (anProperty.value.u[0] != 0);
+            // If the property already exists then replace it by setting a new property value
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<bool>(anName, anValue);
+            }
+            // Otherwise just add the new property value
+            else
+            {
+              theEntity->mProperties.Add<bool>(anName, anValue);
+            }
+          }
+          break;
+        // Is this a color value? then its name started with c or C
+        case LevelMap::PropertyColor:
+          {
+            sf::Color anValue((sf::Uint8)anProperty.value.u[0], (sf::Uint8)anProperty.value.u[1],
+                (sf::Uint8)anProperty.value.u[2], (sf::Uint8)anProperty.value.u[3]);
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<sf::Color>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<sf::Color>(anName, anValue);
+            }
+          }
+          break;
+        // Is this a float value? then its name started with f or F
+        case LevelMap::PropertyFloat:
+          if(theEntity->mProperties.HasID(anName))
+          {
+            theEntity->mProperties.Set<float>(anName, anProperty.value.f[0]);
+          }
+          else
+          {
+            theEntity->mProperties.Add<float>(anName, anProperty.value.f[0]);
+          }
+          break;
+        // Is this a signed numeric property value? then its name started with i or I
+        case LevelMap::PropertyInt32:
+          if(theEntity->mProperties.HasID(anName))
+          {
+            theEntity->mProperties.Set<GQE::Int32>(anName, anProperty.value.i[0]);
+          }
+          else
+          {
+            theEntity->mProperties.Add<GQE::Int32>(anName, anProperty.value.i[0]);
+          }
+          break;
+        // Is this an sf::IntRect property value? then its name started with r or R
+        case LevelMap::PropertyIntRect:
+          {
+#if (SFML_VERSION_MAJOR < 2)
+            sf::IntRect anValue(anProperty.value.i[0], anProperty.value.i[1],
+                anProperty.value.i[0] + anProperty.value.i[2],
+                anProperty.value.i[1] + anProperty.value.i[3]);
+#else
+            sf::IntRect anValue(anProperty.value.i[0], anProperty.value.i[1],
+                anProperty.value.i[2], anProperty.value.i[3]);
+#endif
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<sf::IntRect>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<sf::IntRect>(anName, anValue);
+            }
+          }
+          break;
+        // Is this an unsigned numeric property value? then its name started with u or U
+        case LevelMap::PropertyUint32:
+          if(theEntity->mProperties.HasID(anName))
+          {
+            theEntity->mProperties.Set<GQE::Uint32>(anName, anProperty.value.u[0]);
+          }
+          else
+          {
+            theEntity->mProperties.Add<GQE::Uint32>(anName, anProperty.value.u[0]);
+          }
+          break;
+        // Is this a sf::Vector2f property value? then its name started with v or V
+        case LevelMap::PropertyVector2f:
+          {
+            sf::Vector2f anValue(anProperty.value.f[0], anProperty.value.f[1]);
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<sf::Vector2f>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<sf::Vector2f>(anName, anValue);
+            }
+          }
+          break;
+        // Is this a sf::Vector2u property value? then its name started with w or W
+        case LevelMap::PropertyVector2u:
+          {
+            sf::Vector2u anValue(anProperty.value.u[0], anProperty.value.u[1]);
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<sf::Vector2u>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<sf::Vector2u>(anName, anValue);
+            }
+          }
+          break;
+        // Is this a sf::Vector3f property value? then its name started with z or Z
+        case LevelMap::PropertyVector3f:
+          {
+            sf::Vector3f anValue(anProperty.value.f[0], anProperty.value.f[1],
+                anProperty.value.f[2]);
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<sf::Vector3f>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<sf::Vector3f>(anName, anValue);
+            }
+          }
+          break;
+        // Otherwise its a string property
+        case LevelMap::PropertyString:
+        default:
+          {
+            std::string anValue(theMap.GetString(anProperty.value.u[0]));
+            if(theEntity->mProperties.HasID(anName))
+            {
+              theEntity->mProperties.Set<std::string>(anName, anValue);
+            }
+            else
+            {
+              theEntity->mProperties.Add<std::string>(anName, anValue);
+            }
+          }
+          break;
       }
-
-      // Iterate to the next property
-      anIter++;
-    }
-  } // if(theTile->GetProperties().Empty() == false)
+    } // for(GQE::Uint32 i = theProperties.first; ...)
+  } // if(theEntity != NULL && theProperties.count > 0)
 }
 
 /**
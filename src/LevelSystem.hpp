@@ -8,21 +8,47 @@
  * @date 20120728 - Game Control fixes needed for multiplayer to work correctly
  * @date 20120730 - Improved network synchronization for multiplayer game play
  * @date 20120731 - Add sound effects and player spawn points
+ * @date 20261016 - Load levels from compiled level files
+ * @date 20261016 - Load levels using a background loader thread
+ * @date 20261016 - Store tiles as packed cells with a shared tile type table
+ * @date 20261016 - Cache the typed tile properties of each property set pair
+ * @date 20261016 - Allocate each level from a LevelArena and unload it for real
+ * @date 20261016 - Draw tiles from a tileset atlas built at load time
+ * @date 20261016 - Draw each layer of the current screen with vertex arrays
+ * @date 20261016 - Bake the static layers of each screen into render textures
+ * @date 20261016 - Cache the score label of each player
+ * @date 20261016 - Interpolate player positions between fixed updates
+ * @date 20261016 - Check walls against a wall bitmap of the whole map
+ * @date 20261016 - Index treasures by cell and keep a collected bitset
+ * @date 20261016 - Sweep the bounding box through the wall bitmap
+ * @date 20261016 - Run movement and collision on arrays gathered once per tick
+ * @date 20261016 - Run the movement of each screen on a pool of worker threads
+ * @date 20261016 - Use cached property handles instead of string lookups
+ * @date 20261016 - Keep a dense array of registered IEntity classes
+ * @date 20261016 - Animate every tile type of a map without screen registrations
+ * @date 20261016 - Skip tiles hidden under opaque tiles of higher layers
+ * @date 20261016 - Simulate one game tick every fixed update
+ * @date 20261016 - Save and restore game tick state for rollback
+ * @date 20261016 - Only load a new map once every game tick is confirmed
  */
 #ifndef LEVEL_SYSTEM_HPP_INCLUDED
 #define LEVEL_SYSTEM_HPP_INCLUDED
 
 #include <map>
 #include <deque>
+#include <vector>
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
 #include <GQE/Entity/interfaces/ISystem.hpp>
 #include <GQE/Entity/classes/Prototype.hpp>
 #include <GQE/Entity/Entity_types.hpp>
 #include <GQE/Core/Core_types.hpp>
-#include <TmxParser/TmxMap.h>
-#include <TmxParser/TmxTile.h>
-#include "TmxAsset.hpp"
+#include "LevelArena.hpp"
+#include "LevelAtlas.hpp"
+#include "LevelSemaphore.hpp"
+#include "LevelAsset.hpp"
+#include "PropertyHandle.hpp"
 
 class LevelSystem : public GQE::ISystem
 {
@@ -36,7 +62,6 @@ class LevelSystem : public GQE::ISystem
      * @param[in] theFontFilename to use when showing the percent complete value
      * @param[in] theScreenTileWidth is the number of tiles to display to the screen
      * @param[in] theScreenTileHeight is the number of tiles to display to the screen
-     * @param[in] theLoaderCount is the number of consecutive loader calls in Draw
      */
     LevelSystem(GQE::IApp& theApp,
         GQE::ISystem* theAnimationSystem,
@@ -44,8 +69,7 @@ class LevelSystem : public GQE::ISystem
         const GQE::typeAssetID theLoadingFilename = "",
         const GQE::typeAssetID theFontFilename = "resources/arial.ttf",
         GQE::Uint32 theScreenTileWidth = 32,
-        GQE::Uint32 theScreenTileHeight = 24,
-        GQE::Uint32 theLoaderCount = 100);
+        GQE::Uint32 theScreenTileHeight = 24);
 
     /**
      * LevelSystem dtor
@@ -68,7 +92,8 @@ class LevelSystem : public GQE::ISystem
     /**
      * UpdateFixed is called a specific number of times every game loop and
      * this method will allow each Instance class a chance to have its
-     * UpdateFixed method called for each game loop iteration.
+     * UpdateFixed method called for each game loop iteration. Only map
+     * loading is handled here, see UpdateMovement for moving each IEntity.
      */
     virtual void UpdateFixed(void);
 
@@ -89,6 +114,77 @@ class LevelSystem : public GQE::ISystem
      */
     virtual void Draw(void);
 
+    // Struct to hold the map and every registered IEntity at the start of a
+    // game tick, see SaveState and RestoreState
+    typedef struct sLevelState {
+      GQE::Uint32                    map;       ///< The map loads count when saved
+      std::vector<GQE::Uint32>       collected; ///< Copy of the collected bitset
+      std::vector<GQE::typeEntityID> entity;    ///< ID of each IEntity
+      std::vector<sf::Vector2f>      position;  ///< vPosition of each IEntity
+      std::vector<sf::Vector2u>      screen;    ///< wScreen of each IEntity
+      std::vector<GQE::Uint32>       score;     ///< uScore of each IEntity
+    } LevelState;
+
+    /**
+     * UpdateMovement is called by the NetworkSystem once for every game tick
+     * after velocity values were created. It picks up treasures, checks for
+     * walls and screen edges against every registered IEntity. A new map a
+     * local player asked for is left for LoadPendingMap. Nothing is done
+     * while a map is being loaded.
+     * @param[in] theReplay is true if this game tick is simulated again,
+     *            no sound effects are played
+     */
+    void UpdateMovement(bool theReplay);
+
+    /**
+     * SaveState is responsible for copying everything UpdateMovement changes
+     * into theState provided. The vectors of theState keep their capacity so
+     * saving the state every game tick doesn't allocate memory.
+     * @param[out] theState to copy the current state into
+     */
+    void SaveState(LevelState& theState);
+
+    /**
+     * RestoreState is responsible for putting everything back to theState
+     * provided, making collected treasures visible again if they weren't
+     * collected in theState. The state of a previous map is never restored.
+     * @param[in] theState to restore
+     * @return true if theState was restored, false otherwise
+     */
+    bool RestoreState(const LevelState& theState);
+
+    /**
+     * FinishReplay is called by the NetworkSystem after every game tick
+     * rolled back was simulated again. Screen switches are put off during
+     * a replay, so this switches to the screen the local player ended up on
+     * only if it differs from the current screen.
+     */
+    void FinishReplay(void);
+
+    /**
+     * UpdateRenderStates is called by the NetworkSystem at the end of every
+     * fixed update, once every player has been moved to its final vPosition
+     * for the newest game tick, to start a new interpolation for each
+     * registered IEntity that has moved.
+     */
+    void UpdateRenderStates(void);
+
+    /**
+     * IsMapPending returns true if a local player asked for a new map that
+     * LoadPendingMap hasn't started loading yet.
+     * @return true if a new map is waiting to be loaded, false otherwise
+     */
+    bool IsMapPending(void) const;
+
+    /**
+     * LoadPendingMap is called by the NetworkSystem once every game tick it
+     * simulated is confirmed and starts loading the new map a local player
+     * asked for. A map is never loaded from a predicted game tick since the
+     * state of a previous map can't be restored if that game tick is rolled
+     * back.
+     */
+    void LoadPendingMap(void);
+
     /**
      * SwitchScreen provides a way to switch to a different screen in the level
      * being shown right now. It will first remove each animated tile from the
@@ -110,9 +206,9 @@ class LevelSystem : public GQE::ISystem
     /**
      * LoadMap can be called to attempt to load theFilename map provided. If
      * a load of the map is currently in progress than false will be returned
-     * otherwise the loading of theFilename provided will begin. The Draw
-     * method is responsible for showing a Loading...please wait image during
-     * the loading of the level.
+     * otherwise the loading of theFilename provided will begin on a
+     * background loader thread. The Draw method is responsible for showing a
+     * Loading...please wait image during the loading of the level.
      * @param[in] theMapFilename to open and load
      * @param[in] theLoadingFilename to open and load
      */
@@ -120,10 +216,145 @@ class LevelSystem : public GQE::ISystem
         const GQE::typeAssetID theLoadingFilename);
 
   protected:
+    // Struct to hold the property handles of a registered IEntity, resolved
+    // once by HandleInit so UpdateFixed and Draw never look them up by name
+    typedef struct sPlayerProperties {
+      GQE::IEntity*                    entity;       ///< The IEntity these handles belong to
+      size_t                           index;        ///< Index of this IEntity in mPlayers
+      TPropertyHandle<sf::Vector2f>    position;     ///< vPosition
+      TPropertyHandle<sf::Vector2f>    velocity;     ///< vVelocity
+      TPropertyHandle<sf::Vector2u>    screen;       ///< wScreen
+      TPropertyHandle<sf::Vector2u>    map;          ///< wMap
+      TPropertyHandle<sf::IntRect>     boundingBox;  ///< rBoundingBox
+      TPropertyHandle<sf::IntRect>     spriteRect;   ///< rSpriteRect
+      TPropertyHandle<sf::Sprite>      sprite;       ///< Sprite
+      TPropertyHandle<GQE::Uint32>     score;        ///< uScore
+      TPropertyHandle<bool>            visible;      ///< bVisible
+      TPropertyHandle<bool>            local;        ///< bNetworkLocal
+      TPropertyHandle<bool>            loading;      ///< bLoading
+      TPropertyHandle<GQE::typeAssetID> mapFilename; ///< sMapFilename
+      TPropertyHandle<GQE::typeAssetID> loadingFilename; ///< sLoadingFilename
+    } PlayerProperties;
+
+    // Struct of arrays holding the movement values of every registered IEntity,
+    // gathered from the property bags once per tick in z-order
+    typedef struct sMovementArrays {
+      std::vector<GQE::IEntity*> entity; ///< The IEntity each index was gathered from
+      std::vector<PlayerProperties*> properties; ///< The property handles of entity
+      std::vector<float> x;          ///< vPosition.x
+      std::vector<float> y;          ///< vPosition.y
+      std::vector<float> velocityX;  ///< vVelocity.x
+      std::vector<float> velocityY;  ///< vVelocity.y
+      std::vector<float> boxLeft;    ///< rBoundingBox left
+      std::vector<float> boxTop;     ///< rBoundingBox top
+      std::vector<float> boxWidth;   ///< rBoundingBox width
+      std::vector<float> boxHeight;  ///< rBoundingBox height
+      std::vector<GQE::Uint32> screenX;   ///< wScreen.x
+      std::vector<GQE::Uint32> screenY;   ///< wScreen.y
+      std::vector<GQE::Uint32> mapX;      ///< wMap.x
+      std::vector<GQE::Uint32> mapY;      ///< wMap.y
+      std::vector<GQE::Uint32> tileLeft;  ///< Screen tile column of the left edge after moving
+      std::vector<GQE::Uint32> tileRight; ///< Screen tile column of the right edge after moving
+      std::vector<GQE::Uint32> tileUp;    ///< Screen tile row of the top edge after moving
+      std::vector<GQE::Uint32> tileDown;  ///< Screen tile row of the bottom edge after moving
+      std::vector<GQE::Uint32> score;     ///< uScore
+      std::vector<GQE::Uint8>  visible;   ///< bVisible
+      std::vector<GQE::Uint8>  local;     ///< bNetworkLocal
+      std::vector<GQE::Uint8>  events;    ///< MOVE_BUMPED if a wall was hit this tick
+    } MovementArrays;
+
+    // Struct to hold a treasure picked up by a movement task until it is merged
+    typedef struct sTreasurePickup {
+      GQE::Uint32        entity;   ///< Index into mMovement of the IEntity picking it up
+      GQE::Uint32        treasure; ///< Bit in mCollected of the treasure
+      GQE::Uint32        value;    ///< The uValue of the treasure
+      sf::Vector2u       map;      ///< The map cell of the treasure
+      sf::Vector2u       screen;   ///< The screen of the treasure
+      bool               wall;     ///< True if the treasure cell was also a wall
+    } TreasurePickup;
+
+    // Helper used by MergeMovement to apply treasure pickups in z-order
+    struct TreasureOrder
+    {
+      bool operator()(const TreasurePickup& theLeft, const TreasurePickup& theRight) const
+      {
+        return theLeft.entity < theRight.entity;
+      }
+    };
+
+    // Struct to hold the IEntity indexes of one screen for a movement worker
+    typedef struct sMovementTask {
+      std::vector<GQE::Uint32> entities;      ///< Index into mMovement of each IEntity, in z-order
+      std::vector<TreasurePickup> pickups;    ///< Treasures picked up, applied by MergeMovement
+      GQE::Uint32              screen;        ///< Index of the screen in mScreenTasks
+    } MovementTask;
+
+    /// Enumeration of the movement phases, every task finishes a phase before the next
+    enum MovementPhase {
+      MovementCollect = 0, ///< UpdateCoordinates, CheckTreasure and CheckScreenEdges
+      MovementWalls   = 1  ///< CheckWalls
+    };
+
     /**
-     * UpdateCoordinates is responsible for updating theEntity provided using
-     * its vPosition, wScreen, and rBoundingBox properties and the following
-     * equations.
+     * GatherMovement is responsible for copying the movement properties of
+     * every registered IEntity into mMovement, once per tick.
+     */
+    void GatherMovement(void);
+
+    /**
+     * ScatterMovement is responsible for writing the movement results in
+     * mMovement back to the properties of each IEntity, once per tick.
+     */
+    void ScatterMovement(void);
+
+    /**
+     * RunMovement is responsible for running thePhase provided for every
+     * task in mMovementTasks, using the worker threads when there are enough
+     * registered IEntity classes spread over more than one screen.
+     * @param[in] thePhase to run for every task
+     */
+    void RunMovement(MovementPhase thePhase);
+
+    /**
+     * MovementThread is the entry point of each movement worker thread. The
+     * thread sleeps on mWorkStart until RunMovement has a phase for it and
+     * runs until mWorkersQuit is set.
+     * @param[in] theLevelSystem pointer to the LevelSystem doing the movement
+     */
+    static void MovementThread(void* theLevelSystem);
+
+    /**
+     * MovementWorker is responsible for taking tasks from mMovementTasks and
+     * running the current phase for each one until none are left. It only
+     * touches the IEntity indexes and screen of the task it runs.
+     */
+    void MovementWorker(void);
+
+    /**
+     * MergeMovement is responsible for applying everything thePhase left
+     * for the main thread (treasure pickups, screen switches and sounds) in
+     * z-order, so the result is the same no matter which thread ran a task.
+     * @param[in] thePhase that was just run
+     */
+    void MergeMovement(MovementPhase thePhase);
+
+    /**
+     * PlayCoin is responsible for playing the coin sound matching theValue
+     * of the treasure provided unless a coin sound is already playing.
+     * @param[in] theValue of the treasure picked up
+     */
+    void PlayCoin(GQE::Uint32 theValue);
+
+    /**
+     * PlayBump is responsible for playing the bump sound unless it is
+     * already playing.
+     */
+    void PlayBump(void);
+
+    /**
+     * UpdateCoordinates is responsible for updating the map coordinates of
+     * each IEntity in theTask using its vPosition, wScreen, and
+     * rBoundingBox values and the following equations.
      * TileCenter.x = ((vPosition.x + rBoundingBox.left + rBoundingBox.width / 2) /
      *           Tile.width) % ScreenTile.width
      * TileCenter.y = ((vPosition.y + rBoundingBox.top + rBoundingBox.height / 2) / 
@@ -138,32 +369,84 @@ class LevelSystem : public GQE::ISystem
      *           Tile.height) % ScreenTile.height
      * MapC.x = Tile.x + wScreen.x * ScreenTile.width
      * MapC.y = Tile.y + wScreen.y * ScreenTile.height
-     * @param[in] theEntity to update the map coordinates for
+     * @param[in] theTask holding each IEntity to update
+     */
+    void UpdateCoordinates(MovementTask& theTask);
+
+    /**
+     * CheckTreasure is responsible for checking each IEntity in theTask
+     * against the treasure tiles of its current cell to see if they can
+     * pick it up. Each pickup is added to theTask for MergeMovement.
+     * @param[in] theTask holding each IEntity to check
      */
-    void UpdateCoordinates(GQE::IEntity* theEntity);
+    void CheckTreasure(MovementTask& theTask);
 
     /**
-     * CheckTreasure is responsible for checking theEntity provided against
-     * each treasure tile to see if they can pick it up.
-     * @param[in] theEntity to check treasure against
+     * CheckWalls is responsible for sweeping the bounding box of each
+     * IEntity in theTask through the wall bitmap, one axis at a time, to
+     * determine if they will hit a wall and zero the vVelocity values to
+     * prevent collisions with the wall. A box barely caught on the corner
+     * of a wall slides around it instead, see SlideCorner.
+     * @param[in] theTask holding each IEntity to check
      */
-    void CheckTreasure(GQE::IEntity* theEntity);
+    void CheckWalls(MovementTask& theTask);
 
     /**
-     * CheckWalls is responsible for checking theEntity provided against the
-     * 2D boolean wall index to determine if they will hit a wall and zero
-     * the vVelocity values to prevent collisions with the wall.
-     * @param[in] theEntity to check 2D boolean wall index against
+     * SweepWalls is responsible for walking each cell theEdge of a bounding
+     * box crosses when it moves theDelta pixels along one axis of theScreen,
+     * in every row (or column) the bounding box overlaps, stopping at the
+     * first wall found.
+     * @param[in] theScreen the bounding box is on
+     * @param[in] theEdge leading edge of the bounding box in screen pixels
+     * @param[in] theDelta pixels to move theEdge along the axis
+     * @param[in] theStart of the bounding box across the axis in screen pixels
+     * @param[in] theSize of the bounding box across the axis in pixels
+     * @param[in] theVertical is true to move along y, false to move along x
+     * @return the fraction of theDelta moved before touching a wall, 1.0 if none
      */
-    void CheckWalls(GQE::IEntity* theEntity);
+    float SweepWalls(sf::Vector2u theScreen, float theEdge, float theDelta,
+        float theStart, float theSize, bool theVertical) const;
 
     /**
-     * CheckScreenEdges is responsible for checking theEntity provided against
-     * the edge of the screen to determine if the player should switch to a new
-     * screen.
-     * @param[in] theEntity to check screen edges against
+     * SlideCorner is called when SweepWalls stopped a bounding box after
+     * theTime of its move. If the box only overlaps the line of cells that
+     * stopped it by less than 1/CORNER_SLIDE of a tile, and moving out of
+     * that line lets it get further, the distance to slide across the axis
+     * this tick (at most the length of theDelta) is returned.
+     * @param[in] theScreen the bounding box is on
+     * @param[in] theEdge leading edge of the bounding box in screen pixels
+     * @param[in] theDelta pixels to move theEdge along the axis
+     * @param[in] theStart of the bounding box across the axis in screen pixels
+     * @param[in] theSize of the bounding box across the axis in pixels
+     * @param[in] theVertical is true to move along y, false to move along x
+     * @param[in] theTime returned by SweepWalls for this move
+     * @return the pixels to slide across the axis or 0.0 to stop instead
      */
-    void CheckScreenEdges(GQE::IEntity* theEntity);
+    float SlideCorner(sf::Vector2u theScreen, float theEdge, float theDelta,
+        float theStart, float theSize, bool theVertical, float theTime) const;
+
+    /**
+     * IsWall returns true if theMap cell provided holds a visible wall tile
+     * according to the wall bitmap of the current map.
+     * @param[in] theMap coordinates of the cell to test
+     * @return true if theMap cell is a wall, false otherwise
+     */
+    bool IsWall(sf::Vector2u theMap) const;
+
+    /**
+     * UpdateWall is responsible for updating the wall bitmap bit of theMap
+     * cell provided after one of its wall tiles became invisible.
+     * @param[in] theMap coordinates of the cell to update
+     */
+    void UpdateWall(sf::Vector2u theMap);
+
+    /**
+     * CheckScreenEdges is responsible for checking each IEntity in theTask
+     * against the edge of the screen to determine if the player should
+     * switch to a new screen.
+     * @param[in] theTask holding each IEntity to check
+     */
+    void CheckScreenEdges(MovementTask& theTask);
 
     /**
      * DrawBar is responsible for drawing the percent complete bar using
@@ -203,52 +486,190 @@ class LevelSystem : public GQE::ISystem
       CleanupStage = 5  ///< The Cleanup stage as the game begins
     };
 
+    // Struct to hold the values shared by every cell of the same tile type
+    typedef struct sTileType {
+      sf::Sprite         sprite;   ///< Sprite with the atlas texture and rect for this tile
+      sf::Vector2i       offset;   ///< Where the tileset of this tile was placed in the atlas
+      GQE::Uint32        value;    ///< The uValue property used by treasure tiles
+      GQE::Uint8         flags;    ///< TILE_WALL, TILE_TREASURE and TILE_ANIMATION flags
+      GQE::IEntity*      entity;   ///< Property bag for animated tile types or NULL otherwise
+    } TileType;
+
+    // Struct to hold the typed tile properties LevelSystem cares about
+    typedef struct sTileSchema {
+      GQE::Uint32        value;    ///< The uValue property used by treasure tiles
+      GQE::Uint8         flags;    ///< TILE_WALL, TILE_TREASURE and TILE_ANIMATION flags
+    } TileSchema;
+
+    /// Key of a TileSchema, made of the layer and tile property sets used
+    typedef std::pair<GQE::Uint32, GQE::Uint32> typeSchemaKey;
+
+    // Struct to hold a single map cell, only a few bytes each
+    typedef struct sTileCell {
+      GQE::Uint16        type;     ///< Index into mTileTypes plus one or 0 for an empty cell
+      GQE::Uint8         flags;    ///< TILE_VISIBLE plus the TileType flags for this cell
+      GQE::Uint8         reserved; ///< Keeps each cell 4 bytes in size
+    } TileCell;
+
+    // Struct to refer to a single cell on a screen
+    typedef struct sTileRef {
+      GQE::Uint16        layer;    ///< Which layer the cell is in
+      GQE::Uint16        cell;     ///< Which cell (y * mScreenTileWidth + x) on the screen
+    } TileRef;
+
+    // Struct to hold a single screen, everything it points to lives in a LevelArena
+    typedef struct sScreenInfo {
+      /// mScreenTileWidth * mScreenTileHeight cells for each layer, row by row
+      TileCell*          cells;
+      TileRef*           treasures;     ///< The treasure cells of this screen in cell order
+      /// Index+1 into treasures of the first treasure of each cell or 0 for none
+      GQE::Uint16*       treasureCells;
+      /// Index into mTileTypes of each animated tile type used on this screen
+      GQE::Uint16*       animations;
+      GQE::Uint32        layers;        ///< Number of layers in cells or 0 for an empty screen
+      GQE::Uint32        staticLayers;  ///< Number of bottom layers without treasures or animations
+      GQE::Uint32        numTreasures;  ///< Number of treasures in treasures
+      GQE::Uint32        firstTreasure; ///< Bit in the collected bitset of the first treasure
+      GQE::Uint32        numAnimations; ///< Number of tile types in animations
+    } ScreenInfo;
+
+#if (SFML_VERSION_MAJOR >= 2)
+    // Struct to hold every tile of one layer of the current screen using the same atlas page
+    typedef struct sTileBatch {
+      const sf::Texture* texture;  ///< The atlas page used by every tile in this batch
+      sf::VertexArray    vertices; ///< Four vertices for each tile in this batch
+    } TileBatch;
+
+    // Struct to refer to the vertices of an animated tile in a TileBatch
+    typedef struct sTileQuad {
+      GQE::Uint32        batch;    ///< Which batch in mBatches holds the tile
+      GQE::Uint32        vertex;   ///< The first of the four vertices of the tile
+      GQE::Uint16        type;     ///< Index into mTileTypes of the tile
+    } TileQuad;
+#endif
+
+    // Struct to hold the cached score label drawn above a player
+    typedef struct sScoreLabel {
+      GQE::Uint32        score;    ///< The uScore value this label was built for
+#if (SFML_VERSION_MAJOR < 2)
+      sf::String         text;     ///< The text showing score
+#else
+      sf::VertexArray    vertices; ///< One quad from mDigits for each digit of score
+#endif
+    } ScoreLabel;
+
+    // Struct to hold the last two simulated positions of a player for drawing
+    typedef struct sRenderState {
+      sf::Vector2f       previous; ///< The drawn position when current was simulated
+      sf::Vector2f       current;  ///< The last simulated vPosition value
+      sf::Vector2u       screen;   ///< The wScreen value of current
+      float              elapsed;  ///< Seconds drawn since current was simulated
+      float              interval; ///< Seconds expected until the next simulated position
+      GQE::Uint32        ticks;    ///< Fixed updates since current was simulated
+    } RenderState;
+
     // Struct to hold all values needed to load a map
     typedef struct sLoadContext {
       LoadStage          stage;    ///< The current stage we are processing now
-      TmxAsset           asset;    ///< The map file which is of type Tmx
-      Tmx::Map&          map;      ///< The Tmx::Map object from TmxAsset above
+      LevelAsset         asset;    ///< The compiled level file for the map
+      LevelMap&          map;      ///< The LevelMap object from LevelAsset above
       GQE::ImageAsset    loading;  ///< The Loading, Please Wait background screen to display
-      GQE::ImageAsset*   tilesets; ///< An array of ImageAssets for each Tileset in the map
-      int                tileset;  ///< Which tileset we are loading right now
-      int                layer;    ///< Which layer we are loading right now
-      int                group;    ///< Which group we are loading right now
-      int                object;   ///< Which object we are loading right now
-      int                x;        ///< Which x coordinate for the tile we are loading right now
-      int                y;        ///< Which y coordinate for the tile we are loaidng right now
+      GQE::typeAssetID   previousMap;     ///< mMapFilename to go back to if the load fails
+      GQE::typeAssetID   previousLoading; ///< mLoadingFilename to go back to if the load fails
+      LevelAtlas*        atlas;    ///< The atlas holding every Tileset image in the map
+      std::vector<std::string> sources; ///< The image filename of each Tileset in the map
+      std::vector<GQE::Uint32> colorKeys; ///< The colour key of each Tileset in the map
+      GQE::Uint32        tileset;  ///< Which tileset we are loading right now
+      GQE::Uint32        layer;    ///< Which layer we are loading right now
+      GQE::Uint32        object;   ///< Which object we are loading right now
+      GQE::Uint32        x;        ///< Which x coordinate for the tile we are loading right now
+      GQE::Uint32        y;        ///< Which y coordinate for the tile we are loaidng right now
       GQE::Uint32        total;    ///< The total used to determine percent complete
       float              percent;  ///< The computed percent complete for each stage
+      GQE::Uint32        screenWidth;  ///< The number of screens across the map being loaded
+      GQE::Uint32        screenHeight; ///< The number of screens down the map being loaded
+      GQE::Uint32        tileWidth;    ///< The scaled tile width of the map being loaded
+      GQE::Uint32        tileHeight;   ///< The scaled tile height of the map being loaded
+      LevelArena         arena;    ///< Holds the screens of the map being loaded
+      ScreenInfo*        screens;  ///< The screens being loaded, allocated from arena
+      GQE::Uint32*       walls;    ///< The wall bitmap being loaded, allocated from arena
+      GQE::Uint32*       collected; ///< The collected bitset being loaded, allocated from arena
+      GQE::Uint32        treasures; ///< The number of treasures in the map being loaded
+      std::vector<TileType> tileTypes; ///< The tile types used by the screens being loaded
+      std::vector<GQE::Uint16> typeIndex; ///< Index+1 into tileTypes for each layer and LevelMap::TileType
+      std::map<typeSchemaKey, TileSchema> schemas; ///< Typed tile properties of each property set pair
+      std::vector<sf::Vector2f> positions; ///< The spawn positions being loaded
+      sf::Thread*        thread;   ///< The loader thread or NULL once it has been joined
+      sf::Mutex          mutex;    ///< Protects the values below shared with the loader thread
+      float              progress; ///< The percent complete published for DrawBar
+      bool               done;     ///< True when the loader thread has finished
+      bool               cancel;   ///< True when the loader thread should stop early
       sLoadContext(GQE::typeAssetID theMapFilename,
           GQE::typeAssetID theLoadingFilename) :
         stage(UnknownStage),
-        asset(theMapFilename, GQE::AssetLoadNow),
+        asset(theMapFilename),
         map(asset.GetAsset()),
         loading(theLoadingFilename, GQE::AssetLoadNow),
-        tilesets(NULL),
+        atlas(NULL),
         tileset(0),
         layer(0),
-        group(0),
         object(0),
         x(0),
         y(0),
         total(1),
-        percent(0.0f)
+        percent(0.0f),
+        screenWidth(0),
+        screenHeight(0),
+        tileWidth(0),
+        tileHeight(0),
+        screens(NULL),
+        walls(NULL),
+        collected(NULL),
+        treasures(0),
+        thread(NULL),
+        progress(0.0f),
+        done(false),
+        cancel(false)
       {
       }
     } LoadContext;
 
-    typedef struct sScreenInfo {
-      std::map<const GQE::Uint32, std::deque<GQE::IEntity*> > tiles;
-      std::deque<GQE::IEntity*> walls;
-      std::deque<GQE::IEntity*> treasures;
-    } ScreenInfo;
+    static const GQE::Uint8 TILE_VISIBLE   = 0x01; // Cell is visible (treasure not collected yet)
+    static const GQE::Uint8 TILE_WALL      = 0x02; // Cell is a wall (bWall)
+    static const GQE::Uint8 TILE_TREASURE  = 0x04; // Cell is a treasure (bTreasure)
+    static const GQE::Uint8 TILE_ANIMATION = 0x08; // Cell is animated (bAnimation)
+    static const GQE::Uint8 TILE_OPAQUE    = 0x10; // Cell is covered entirely by its opaque tile
+    static const GQE::Uint8 TILE_HIDDEN    = 0x20; // Cell is under an opaque tile, never drawn
+
+    /// The character size of the score label drawn above each player
+    static const unsigned int SCORE_SIZE = 16;
+
+    /// Set in MovementArrays::events when CheckWalls stopped the IEntity
+    static const GQE::Uint8 MOVE_BUMPED = 0x01;
+
+    /// A bounding box that overlaps a wall by less than 1/CORNER_SLIDE of a
+    /// tile across its move slides around the corner instead of stopping
+    static const GQE::Uint32 CORNER_SLIDE = 2;
+
+    /// The most extra threads helping the main thread with movement tasks,
+    /// one less than the number of processors online is started
+    static const GQE::Uint32 MAX_WORKER_THREADS = 7;
+
+    /// The fewest registered IEntity classes worth using the worker threads
+    /// for, waking a worker costs more than moving a handful of players so
+    /// a normal game with a few players always moves them on the main thread
+    static const GQE::Uint32 PARALLEL_ENTITIES = 64;
+
+    /// The most fixed updates between two simulated positions of a player,
+    /// the NetworkSystem moves players every fixed update unless it waits
+    static const GQE::Uint32 RENDER_TICKS = 4;
 
     // Variables
     /////////////////////////////////////////////////////////////////////////
     GQE::ISystem*      mAnimationSystem;
     GQE::Prototype     mTile;
     GQE::Prototype     mObject;
-    GQE::ImageAsset*   mTilesets;
+    LevelAtlas*        mAtlas;
     GQE::SoundAsset*   mSounds;
     GQE::Uint32        mScreenTileWidth;
     GQE::Uint32        mScreenTileHeight;
@@ -261,13 +682,76 @@ class LevelSystem : public GQE::ISystem
     GQE::typeAssetID   mLoadingFilename;
     sf::Vector2u       mScreen;
     sf::Font           mFont;
+#if (SFML_VERSION_MAJOR >= 2)
+    // The digits 0 to 9 of mFont, rasterized once for every score label
+    sf::Glyph          mDigits[10];
+#endif
+    // The property handles of each registered IEntity
+    std::map<const GQE::typeEntityID, PlayerProperties> mPlayerProperties;
+    // Every registered IEntity in no particular order, for loops where the
+    // z-order of mEntities doesn't matter
+    std::vector<PlayerProperties*> mPlayers;
+    // The cached score label of each registered IEntity
+    std::map<const GQE::typeEntityID, ScoreLabel> mScoreLabels;
+    // The interpolated drawing position of each registered IEntity
+    std::map<const GQE::typeEntityID, RenderState> mRenderStates;
+    // The movement values of each registered IEntity for the current tick
+    MovementArrays     mMovement;
+    // One movement task per screen, only the first mNumMovementTasks are used
+    std::vector<MovementTask> mMovementTasks;
+    // The movement task plus one of each screen this tick or 0 if it has none
+    std::vector<GQE::Uint32> mScreenTasks;
+    // Every treasure pickup of the current tick in z-order
+    std::vector<TreasurePickup> mPickups;
+    // The worker threads helping with mMovementTasks, started when first
+    // needed, one less than the number of processors up to MAX_WORKER_THREADS
+    std::vector<sf::Thread*> mWorkers;
+    // Posted once for each worker thread that should run the current phase
+    LevelSemaphore     mWorkStart;
+    // Posted by each worker thread when it has run the current phase
+    LevelSemaphore     mWorkDone;
+    // True when the worker threads should return instead of running a phase
+    bool               mWorkersQuit;
+    // Protects mNextTask shared by the worker threads
+    sf::Mutex          mMovementMutex;
+    // The phase the workers are running now
+    MovementPhase      mMovementPhase;
+    // The number of tasks in mMovementTasks used this tick
+    GQE::Uint32        mNumMovementTasks;
+    // The next task in mMovementTasks nobody has taken yet
+    GQE::Uint32        mNextTask;
     sf::Sound          mBump;
     sf::Sound          mCoin;
     LoadContext*       mLoader;
-    GQE::Uint32        mLoaderCount;
-    // Map of screens to each z-ordered deque of IEntity* tiles for rendering purposes
-    std::map<const GQE::Uint32, ScreenInfo> mScreens;
+    // Holds every screen, cell and tile list of the current map
+    LevelArena         mArena;
+    // Array of mScreenWidth * mScreenHeight screens allocated from mArena
+    ScreenInfo*        mScreens;
+    // One bit per map cell, row by row, set for each visible wall (bWall)
+    GQE::Uint32*       mWalls;
+    // One bit per treasure of the map, set once the treasure was collected
+    GQE::Uint32*       mCollected;
+    // The number of treasures in mCollected
+    GQE::Uint32        mNumTreasures;
+    // Incremented every time a map is published, kept in each LevelState
+    GQE::Uint32        mMapLoads;
+    // True while UpdateMovement simulates a game tick again
+    bool               mReplaying;
+    // The tile types shared by every cell in mScreens
+    std::vector<TileType> mTileTypes;
     std::vector<sf::Vector2f> mPositions;
+#if (SFML_VERSION_MAJOR >= 2)
+    // The tiles of the current screen, one batch per layer and atlas page
+    std::vector<TileBatch> mBatches;
+    // The vertices of each animated tile in mBatches
+    std::vector<TileQuad> mAnimatedQuads;
+    // True if mBatches must be rebuilt before they are drawn again
+    bool               mBatchesDirty;
+    // The static layers of the current screen and its neighbours, baked once
+    std::map<const GQE::Uint32, sf::RenderTexture*> mBakedScreens;
+    // The baked static layers of the current screen or NULL if not baked
+    sf::RenderTexture* mBaked;
+#endif
 
     /**
      * ResetProperties will set the LevelSystem properties of all IEntity
@@ -279,43 +763,175 @@ class LevelSystem : public GQE::ISystem
     //void ResetProperties(bool theVisible);
 
     /**
-     * DropAllScreens is responsible for unloading and deleting each screen
-     * deque. This is called when loading a new map or by the destructor.
+     * GetPlayerProperties returns the property handles for theEntity
+     * provided, resolving them and adding theEntity to mPlayers the first
+     * time theEntity is used.
+     * @param[in] theEntity to return the property handles for
+     * @return the property handles for theEntity
+     */
+    PlayerProperties& GetPlayerProperties(GQE::IEntity* theEntity);
+
+    /**
+     * GetScoreLabel returns the cached score label for theEntity provided,
+     * the label is only rebuilt when the uScore value of theEntity changes.
+     * @param[in] theEntity to return the score label for
+     * @param[in] theScore is the uScore value of theEntity
+     * @return the score label for theEntity
+     */
+    ScoreLabel& GetScoreLabel(GQE::IEntity* theEntity, GQE::Uint32 theScore);
+
+    /**
+     * UpdateRenderState is called by UpdateRenderStates for theEntity
+     * provided and starts a new interpolation each time its vPosition value
+     * changes.
+     * Screen switches are never interpolated.
+     * @param[in] theEntity to update the render state for
+     * @param[in] thePosition is the vPosition value of theEntity
+     * @param[in] theScreen is the wScreen value of theEntity
+     */
+    void UpdateRenderState(GQE::IEntity* theEntity, sf::Vector2f thePosition,
+        sf::Vector2u theScreen);
+
+    /**
+     * GetRenderPosition returns the position to draw theEntity at, which is
+     * between the last two simulated vPosition values of theEntity.
+     * @param[in] theEntity to return the drawing position for
+     * @return the interpolated position of theEntity
+     */
+    sf::Vector2f GetRenderPosition(GQE::IEntity* theEntity);
+
+    /**
+     * DropAllScreens is responsible for unloading the current screen and
+     * releasing every screen, tile type and tile list of the current map all
+     * at once. This is called when publishing a new map or by the destructor.
      */
     void DropAllScreens(void);
 
     /**
-     * LoadScreen is responsible for adding each Instance to the RenderSystem
-     * to theScreen specified.
-     * @param[in] theScreen to load by adding each Instance to mRenderSystem
+     * DropTileTypes is responsible for deleting the property bag of each
+     * animated tile type in theTileTypes provided and then clearing it.
+     * @param[in] theTileTypes to delete and clear
+     */
+    void DropTileTypes(std::vector<TileType>& theTileTypes);
+
+    /**
+     * GetScreen returns the ScreenInfo for theScreen provided
+     * @param[in] theScreen to retrieve
+     * @return the ScreenInfo or NULL if theScreen is outside the current map
+     */
+    ScreenInfo* GetScreen(sf::Vector2u theScreen);
+
+    /**
+     * LoadScreen is responsible for making theScreen specified the current
+     * screen and building its tile batches.
+     * @param[in] theScreen to load
      */
     void LoadScreen(sf::Vector2u theScreen);
 
     /**
-     * UnloadScreen is responsible for dropping each Instance from the
-     * RenderSystem for theScreen specified.
-     * @param[in] theScreen to unload
+     * AddTileAnimations is responsible for adding the property bag of every
+     * animated tile type of the current map to our AnimationSystem once,
+     * DrawTiles reads the current frame of each type from its property bag.
      */
-    void UnloadScreen(sf::Vector2u theScreen);
+    void AddTileAnimations(void);
 
     /**
-     * LoadStage1 will be called by the Draw method to perform stage 1 of the
-     * loading process. This stage is responsible for loading each tileset
-     * which is used to represent each tile in the map. By providing loading in
+     * DropTileAnimations is responsible for dropping the property bag of
+     * every animated tile type of the current map from our AnimationSystem.
+     */
+    void DropTileAnimations(void);
+
+#if (SFML_VERSION_MAJOR >= 2)
+    /**
+     * LoadTileBatches is responsible for building one vertex array for each
+     * layer and atlas page used by the visible tiles of the current screen,
+     * so DrawTiles can draw the whole screen with a few draw calls.
+     */
+    void LoadTileBatches(void);
+
+    /**
+     * AddTileBatches is responsible for adding the visible tiles from
+     * theFirstLayer up to theLastLayer of theInfo screen provided to
+     * theBatches, one batch for each layer and atlas page used.
+     * @param[in] theInfo screen to add the tiles of
+     * @param[in] theFirstLayer to add
+     * @param[in] theLastLayer to stop at (not added)
+     * @param[in] theBatches to add to
+     * @param[in] theQuads to add each animated tile to or NULL
+     */
+    void AddTileBatches(const ScreenInfo& theInfo, GQE::Uint32 theFirstLayer,
+        GQE::Uint32 theLastLayer, std::vector<TileBatch>& theBatches,
+        std::vector<TileQuad>* theQuads);
+
+    /**
+     * BakeScreen is responsible for drawing the static layers of theScreen
+     * provided into a render texture once and keeping it in mBakedScreens.
+     * @param[in] theScreen to bake
+     * @return the baked screen or NULL if theScreen has no static layers
+     */
+    sf::RenderTexture* BakeScreen(sf::Vector2u theScreen);
+
+    /**
+     * BakeNextScreen is called after each frame is drawn and bakes at most
+     * one neighbour of the current screen, so switching screens never has
+     * to wait for the new screen to be baked.
+     */
+    void BakeNextScreen(void);
+
+    /**
+     * DropBakedScreens is responsible for deleting the baked screens that
+     * are no longer next to the current screen or every baked screen.
+     * @param[in] theAll is true to delete every baked screen
+     */
+    void DropBakedScreens(bool theAll);
+#endif
+
+    /**
+     * LoadThread is the entry point of the loader thread started by LoadMap.
+     * @param[in] theLevelSystem pointer to the LevelSystem doing the loading
+     */
+    static void LoadThread(void* theLevelSystem);
+
+    /**
+     * LoadWorker will be called by the loader thread to load the map asset
+     * and then perform stages 1 through 3 of the loading process without
+     * touching anything outside of mLoader. The percent complete is published
+     * into mLoader->progress for DrawBar as each step completes.
+     */
+    void LoadWorker(void);
+
+    /**
+     * LoadPublish will be called by the UpdateFixed method once the loader
+     * thread is done. It joins the loader thread and publishes the screens
+     * and spawn positions that were loaded all at once.
+     */
+    void LoadPublish(void);
+
+    /**
+     * LoadStage1 will be called by the loader thread to perform stage 1 of
+     * the loading process. This stage is responsible for packing each tileset
+     * which is used to represent each tile in the map into the LevelAtlas. By providing loading in
      * a multi-stage technique we can provided a Loading...please wait
      * mechanism with a progress bar.
      */
     void LoadStage1(void);
 
     /**
-     * LoadStage2 will be called by the Draw method to perform stage 2 of the
+     * LoadStage2 will be called by the loader thread to perform stage 2 of the
      * loading process. This stage is responsible for loading each tile or
      * object that will be drawn. 
      */
     void LoadStage2(void);
 
     /**
-     * LoadStage3 will be called by the Draw method to perform stage 3 of the
+     * LoadTileLists will be called by LoadStage2 once every cell has been
+     * loaded. It counts and then fills in the wall, treasure and animation
+     * lists of each screen using memory from the loader arena.
+     */
+    void LoadTileLists(void);
+
+    /**
+     * LoadStage3 will be called by the loader thread to perform stage 3 of the
      * loading process. This stage is responsible for completing any final
      * steps after the tiles and objects have been loaded.
      * @return true if this loading stage has been completed
@@ -323,17 +939,40 @@ class LevelSystem : public GQE::ISystem
     void LoadStage3(void);
 
     /**
-     * LoadStage4 will be called by the Draw method to perform stage 4 of the
-     * loading process. This stage is responsible for informing all of the other
-     * players that we have finished loading our map and waiting for them to
-     * complete loading their maps.
+     * LoadTileType will be called by LoadStage2 the first time theType tile
+     * from the compiled level is found on theLayer provided. It creates the
+     * shared property bag for this tile using the layer and tile properties
+     * and adds a new TileType to mLoader->tileTypes.
+     * @param[in] theLayer the tile was found on
+     * @param[in] theType index of the LevelMap::TileType found
+     * @return the index plus one of the new TileType or 0 if none was created
+     */
+    GQE::Uint16 LoadTileType(GQE::Uint32 theLayer, GQE::Uint32 theType);
+
+    /**
+     * LoadSchema is responsible for returning the typed tile properties for
+     * theLayer and theTile property sets provided. Each distinct pair of
+     * property sets is only looked at once per map, every tile type sharing
+     * the same pair shares the same cached TileSchema.
+     * @param[in] theLayer property set of the layer the tile was found on
+     * @param[in] theTile property set of the tile
+     * @return the cached TileSchema for this pair of property sets
+     */
+    const TileSchema& LoadSchema(const LevelMap::Range theLayer,
+        const LevelMap::Range theTile);
+
+    /**
+     * LoadStage4 will be called by the UpdateFixed method to perform stage 4
+     * of the loading process. This stage is responsible for informing all of
+     * the other players that we have finished loading our map and waiting for
+     * them to complete loading their maps.
      */
     void LoadStage4(void);
 
     /**
-     * LoadStage5 will be called by the Draw method to perform stage 5 of the
-     * loading process. This stage is responsible for enabling the game to
-     * begin since all players have finally loaded their maps.
+     * LoadStage5 will be called by the UpdateFixed method to perform stage 5
+     * of the loading process. This stage is responsible for enabling the game
+     * to begin since all players have finally loaded their maps.
      */
     void LoadStage5(void);
 
@@ -341,12 +980,14 @@ class LevelSystem : public GQE::ISystem
      * LoadProperties is responsible for adding each property as a property of
      * theEntity provided. Property names begin with a special letter
      * that determines the type of each property. These include i=GQE::Int32,
-     * u=GQE::Uint32, f=float, b=boolean, s=string, etc.
-     * @param[in] theProperties to processs
+     * u=GQE::Uint32, f=float, b=boolean, s=string, etc. Each property was
+     * already parsed into its type when the compiled level file was created.
+     * @param[in] theMap containing theProperties
+     * @param[in] theProperties range to processs
      * @param[in] theEntity to store each property into
      */
-    void LoadProperties(std::map<std::string, std::string> theProperties,
-        GQE::IEntity* theEntity); 
+    void LoadProperties(const LevelMap& theMap,
+        const LevelMap::Range theProperties, GQE::IEntity* theEntity);
 };
 #endif // LEVEL_CONTROL_SYSTEM_HPP_INCLUDED
 
@@ -8,17 +8,56 @@
  * @date 20120730 - Improved network synchronization for multiplayer game play
  * @date 20120731 - Add sound effects and player spawn points
  * @date 20120910 - Fix SFML v1.6 issues
+ * @date 20261016 - Use cached property handles instead of string lookups
+ * @date 20261016 - Simulate one game tick every fixed update
+ * @date 20261016 - Send input packets in a compact binary layout
+ * @date 20261016 - Find remote players by uNetworkID without a search
+ * @date 20261016 - Send a window of input ticks in every input packet
+ * @date 20261016 - Predict remote input and roll back on late input
+ * @date 20261016 - Never commit input a remote player can no longer be sent
+ * @date 20261016 - Only load a new map once every game tick is confirmed
  */
 #include "NetworkSystem.hpp"
+#include <cmath>
 #include <SFML/Network.hpp>
 #include <GQE/Entity/classes/Instance.hpp>
 #include "TnTApp.hpp"
 
-NetworkSystem::NetworkSystem(TnTApp& theApp):
+/// Write theValue to theData in network byte order
+static void PutUint16(GQE::Uint8* theData, GQE::Uint16 theValue)
+{
+  theData[0] = (GQE::Uint8)(theValue >> 8);
+  theData[1] = (GQE::Uint8)(theValue & 0xFF);
+}
+
+/// Write theValue to theData in network byte order
+static void PutUint32(GQE::Uint8* theData, GQE::Uint32 theValue)
+{
+  PutUint16(theData, (GQE::Uint16)(theValue >> 16));
+  PutUint16(theData + 2, (GQE::Uint16)(theValue & 0xFFFF));
+}
+
+/// Read a value in network byte order from theData
+static GQE::Uint16 GetUint16(const GQE::Uint8* theData)
+{
+  return (GQE::Uint16)((theData[0] << 8) | theData[1]);
+}
+
+/// Read a value in network byte order from theData
+static GQE::Uint32 GetUint32(const GQE::Uint8* theData)
+{
+  return ((GQE::Uint32)GetUint16(theData) << 16) | GetUint16(theData + 2);
+}
+
+NetworkSystem::NetworkSystem(TnTApp& theApp, LevelSystem& theLevelSystem):
   ISystem("NetworkSystem", theApp),
-  mUpdateStep(ActionWait),
   mGameTick(0),
-  mClient(theApp.mClient)
+  mConfirmedTick(0),
+  mRollbackTick(0),
+  mInputDelay(PREDICT_TICKS > 0 ? 1 : INPUT_DELAY),
+  mLevelSystem(theLevelSystem),
+  mClient(theApp.mClient),
+  mRemotesDirty(true)
 {
 }
 
@@ -45,6 +84,11 @@ void NetworkSystem::AddProperties(GQE::IEntity* theEntity)
 
 void NetworkSystem::HandleInit(GQE::IEntity* theEntity)
 {
+  // Resolve the property handles of theEntity once
+  GetNetworkProperties(theEntity);
+
+  // Let GetRemoteProperties find the new remote player
+  mRemotesDirty = true;
 }
 
 void NetworkSystem::HandleEvents(sf::Event theEvent)
@@ -53,230 +97,203 @@ void NetworkSystem::HandleEvents(sf::Event theEvent)
 
 void NetworkSystem::UpdateFixed()
 {
-  // Did someone initiate loading a new level?
-  bool anLoading = false;
-
-  // How many players have committed keyboard state information?
-  unsigned int anCount = 0;
-  unsigned int anTotal = 0;
-
-  // Iterator for looping through each IEntity class
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
+  // See if there is any remote input information to receive
+  ReceiveRemoteInput();
 
-  // Which step are we on right now for UpdateFixed?
-  switch(mUpdateStep)
+  // Did we act on mispredicted remote input? then go back and do it again
+  if(mRollbackTick > 0)
   {
-  case ActionWait:
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+    if(mLevelSystem.RestoreState(mStates[mRollbackTick & (INPUT_WINDOW - 1)]))
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      for(unsigned int anTick = mRollbackTick; anTick <= mGameTick; anTick++)
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
-
-        // Increment the IEntity iterator second
-        anQueue++;
+        SimulateTick(anTick, true);
+      }
 
-        // Are we a local player who needs to send our keyboard state?
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
-        {
-          // Send local input for this local player to other remote players
-          SendLocalInput(anEntity);
-        }
-        else
-        {
-          // See if there is any remote input information to receive
-          ReceiveRemoteInput();
-        }
-        
-        // Has this player finished loading their level?
-        if(anEntity->mProperties.Get<bool>("bLoading") == false)
-        {
-          // Increment our committed count number
-          anCount++;
-        }
+      // Switch screens once, if the local player ended up somewhere else
+      mLevelSystem.FinishReplay();
+    }
+    else
+    {
+      WLOG() << "NetworkSystem::UpdateFixed() unable to roll back to gt="
+        << mRollbackTick << std::endl;
+    }
+    mRollbackTick = 0;
+  }
 
-        // Increment our total committed members count
-        anTotal++;
-      } // while(anQueue != anIter->second.end())
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
-
-    //ILOG() << "NetworkSystem::ActionWait gt=" << mGameTick
-    //  << " count=" << anCount << " total=" << anTotal << std::endl;
-    // Have we received all committed members, then act on commitment
-    if(anCount == anTotal)
+  // Has every player (or every local player) committed keyboard state
+  // information for the next game tick?
+  const unsigned int anTick = mGameTick + 1;
+  unsigned int anCount = 0;
+  unsigned int anLocalCount = 0;
+  unsigned int anLocalTotal = 0;
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    const bool anCommitted =
+      mPlayers[anIndex]->inputs[anTick & (INPUT_WINDOW - 1)].tick == anTick;
+    if(anCommitted)
     {
-      // Switch to next step
-      mUpdateStep = ActionCommit;
+      // Increment our committed count number
+      anCount++;
     }
-    break;
-  case ActionCommit: // Gather local keystate information
+    if(mPlayers[anIndex]->local.Get())
+    {
+      anLocalTotal++;
+      if(anCommitted)
+      {
+        anLocalCount++;
+      }
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+
+  //ILOG() << "NetworkSystem::UpdateFixed gt=" << mGameTick << " ct=" << mConfirmedTick
+  //  << " count=" << anCount << " total=" << mPlayers.size() << std::endl;
+  // Act on the next game tick if every player committed input for it or if
+  // the missing remote input can still be predicted, but never predict past
+  // a game tick that asked for a new map
+  if((anCount > 0 && anCount == mPlayers.size()) ||
+      (anLocalCount > 0 && anLocalCount == anLocalTotal &&
+       anTick - mConfirmedTick <= PREDICT_TICKS && mLevelSystem.IsMapPending() == false))
+  {
     // Increment our game tick value
-    mGameTick++;
+    mGameTick = anTick;
+
+    SimulateTick(anTick, false);
+  }
 
-    //ILOG() << "NetworkSystem::ActionCommit gt=" << mGameTick << std::endl;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+  // Confirm every simulated game tick every player has committed input for
+  bool anConfirmed = true;
+  while(anConfirmed && mConfirmedTick < mGameTick)
+  {
+    const unsigned int anNext = mConfirmedTick + 1;
+    for(size_t anIndex = 0; anIndex < mPlayers.size() && anConfirmed; anIndex++)
+    {
+      anConfirmed = mPlayers[anIndex]->inputs[anNext & (INPUT_WINDOW - 1)].tick == anNext;
+    }
+    if(anConfirmed)
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
+        NetworkProperties& anProperties = *mPlayers[anIndex];
+        anProperties.lastKeyState = anProperties.inputs[anNext & (INPUT_WINDOW - 1)].keyState;
+      }
+      mConfirmedTick = anNext;
+    }
+  }
 
-        // Increment the IEntity iterator second
-        anQueue++;
+  // Load a new map only once no game tick simulated can be rolled back
+  if(mConfirmedTick == mGameTick)
+  {
+    mLevelSystem.LoadPendingMap();
+  }
 
-        // Are we a local player who needs to get our current keyboard state?
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
-        {
-          // Save previous KeyState information
-          anEntity->mProperties.Set<GQE::Uint32>("uKeyStatePrevious", 
-            anEntity->mProperties.Get<GQE::Uint32>("uKeyState"));
+  // Let LevelSystem interpolate towards the final position of every player
+  mLevelSystem.UpdateRenderStates();
+}
 
-          // Save previous Position information
-          anEntity->mProperties.Set<sf::Vector2f>("vPositionPrevious", 
-            anEntity->mProperties.Get<sf::Vector2f>("vPosition"));
+void NetworkSystem::SimulateTick(unsigned int theTick, bool theReplay)
+{
+  // Remote players start this game tick where they said they would
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    NetworkProperties& anProperties = *mPlayers[anIndex];
+    const NetworkInput& anInput = anProperties.inputs[theTick & (INPUT_WINDOW - 1)];
+    if(anProperties.local.Get() == false && anInput.stateTick == theTick)
+    {
+      anProperties.position.Set(anInput.position);
+      anProperties.screen.Set(anInput.screen);
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 
-          // Save previous Screen information
-          anEntity->mProperties.Set<sf::Vector2u>("wScreenPrevious", 
-            anEntity->mProperties.Get<sf::Vector2u>("wScreen"));
+  // Save the state theTick starts from in case we need to roll back to it
+  if(PREDICT_TICKS > 0)
+  {
+    mLevelSystem.SaveState(mStates[theTick & (INPUT_WINDOW - 1)]);
+  }
 
-          // Save previous Loading information
-          anEntity->mProperties.Set<bool>("bLoadingPrevious", 
-            anEntity->mProperties.Get<bool>("bLoading"));
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    // Get the property handles and committed input of this player
+    NetworkProperties& anProperties = *mPlayers[anIndex];
+    NetworkInput& anInput = anProperties.inputs[theTick & (INPUT_WINDOW - 1)];
 
-          // Gather input for this local player
-          UpdateLocalInput(anEntity);
-        }
-        //ILOG() << "NetworkState::ActionCommit id=" << anEntity->GetID() << " uKeyState=" << 
-        //  anEntity->mProperties.Get<GQE::Uint32>("uKeyState") << std::endl;
-        //ILOG() << "NetworkState::ActionCommit position(" <<
-        //  anEntity->mProperties.Get<sf::Vector2f>("vPosition").x << ", " <<
-        //  anEntity->mProperties.Get<sf::Vector2f>("vPosition").y << ")" << std::endl;
-        //ILOG() << "NetworkState::ActionCommit screen(" <<
-        //  anEntity->mProperties.Get<sf::Vector2u>("wScreen").x << ", " <<
-        //  anEntity->mProperties.Get<sf::Vector2u>("wScreen").y << ")" << std::endl;
-
-      } // while(anQueue != anIter->second.end())
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
-
-    // Switch to next step
-    mUpdateStep = ActionBroadcast;
-    break;
-  case ActionBroadcast: // Send local and receive remote keystate information
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+    // Use the committed input or predict it from the newest input received
+    GQE::Uint32 anKeyState = anProperties.lastKeyState;
+    if(anInput.tick == theTick)
+    {
+      anKeyState = anInput.keyState;
+    }
+    else
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      for(unsigned int anTick = theTick - 1; anTick > mConfirmedTick; anTick--)
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
-
-        // Increment the IEntity iterator second
-        anQueue++;
-
-        // Are we a local player who needs to send our keyboard state?
-        if(anEntity->mProperties.Get<bool>("bNetworkLocal"))
+        const NetworkInput& anPrevious = anProperties.inputs[anTick & (INPUT_WINDOW - 1)];
+        if(anPrevious.tick == anTick)
         {
-          // Send local input for this local player to other remote players
-          SendLocalInput(anEntity);
-        }
-        else
-        {
-          // See if there is any remote input information to receive
-          ReceiveRemoteInput();
-        }
-        
-        // Does this player have a committed keyboard state?
-        if(anEntity->mProperties.Get<bool>("bKeyState"))
-        {
-          // Increment our committed count number
-          anCount++;
+          anKeyState = anPrevious.keyState;
+          break;
         }
+      }
+    }
 
-        // Has this player started loading a new level?
-        if(anEntity->mProperties.Get<bool>("bLoading"))
-        {
-          anLoading = true;
-        }
+    // Remember what we acted on so late input can be checked against it
+    const NetworkInput& anLast = anProperties.inputs[(theTick - 1) & (INPUT_WINDOW - 1)];
+    const GQE::Uint32 anKeyStatePrevious =
+      (anLast.simulatedTick == theTick - 1) ? anLast.simulated : anProperties.keyState.Get();
+    anInput.simulatedTick = theTick;
+    anInput.simulated = anKeyState;
 
-        // Increment our total committed members count
-        anTotal++;
-      } // while(anQueue != anIter->second.end())
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
+    // Make note of the keystate information
+    anProperties.keyStatePrevious.Set(anKeyStatePrevious);
+    anProperties.keyState.Set(anKeyState);
+    anProperties.keyStateValid.Set(true);
 
-    //ILOG() << "NetworkSystem::ActionBroadcast count=" << anCount << " total=" << anTotal << std::endl;
-    // Have we received all committed members, then act on commitment
-    if(anCount == anTotal && anLoading == false)
-    {
-      // Switch to next step
-      mUpdateStep = ActionVelocity;
-    }
-    else if(anLoading == true)
+    // Process the input keystate information for this Entity
+    ProcessInput(anProperties);
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+
+  // Let LevelSystem check the velocity values for treasures and walls
+  mLevelSystem.UpdateMovement(theReplay);
+
+  // Use velocity information sanitized by LevelSystem to move positions
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    // Process the velocity information for this Entity
+    ProcessVelocity(*mPlayers[anIndex]);
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+}
+
+void NetworkSystem::CommitLocalInput(void)
+{
+  // Has someone started loading a new level?
+  bool anLoading = false;
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    if(mPlayers[anIndex]->loading.Get())
     {
-      // Switch to wait step
-      mUpdateStep = ActionWait;
+      anLoading = true;
     }
-    break;
-  case ActionVelocity: // Use keystate information received to generate velocity information
-    //ILOG() << "NetworkSystem::ActionVelocity gt=" << mGameTick << std::endl;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
-    {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
-      {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
-
-        // Increment the IEntity iterator second
-        anQueue++;
-
-        // Process the input keystate information for this Entity
-        ProcessInput(anEntity);
-      } // while(anQueue != anIter->second.end())
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
-
-    // Switch to next step
-    mUpdateStep = ActionPosition;
-    break;
-  case ActionPosition: // Use velocity information sanitized by LevelSystem to move positions
-    //ILOG() << "NetworkSystem::ActionPosition gt=" << mGameTick << std::endl;
-    anIter = mEntities.begin();
-    while(anIter != mEntities.end())
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    // Get the property handles of this player
+    NetworkProperties& anProperties = *mPlayers[anIndex];
+
+    // Are we a local player who needs to send our keyboard state?
+    if(anProperties.local.Get())
     {
-      std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-      while(anQueue != anIter->second.end())
+      // Commit input for the next game ticks unless someone is still loading
+      if(anLoading == false)
       {
-        // Get the IEntity address first
-        GQE::IEntity* anEntity = *anQueue;
-
-        // Increment the IEntity iterator second
-        anQueue++;
-
-        // Process the input keystate information for this Entity
-        ProcessVelocity(anEntity);
-      } // while(anQueue != anIter->second.end())
-      // Increment map iterator
-      anIter++;
-    } //while(anIter != mEntities.end())
-
-    // Switch to first step
-    mUpdateStep = ActionCommit;
-    break;
-  }
+        // Gather input for this local player
+        UpdateLocalInput(anProperties);
+      }
+
+      // Send our newest input every time in case the last one was lost
+      SendLocalInput(anProperties);
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 }
 
 void NetworkSystem::UpdateVariable(float theElaspedTime)
@@ -289,20 +306,129 @@ void NetworkSystem::Draw()
 
 void NetworkSystem::HandleCleanup(GQE::IEntity* theEntity)
 {
+  std::map<const GQE::typeEntityID, NetworkProperties>::iterator anIter =
+    mNetworkProperties.find(theEntity->GetID());
+  if(anIter != mNetworkProperties.end())
+  {
+    // Move the last IEntity into the slot of theEntity in mPlayers
+    const size_t anIndex = anIter->second.index;
+    mPlayers[anIndex] = mPlayers.back();
+    mPlayers[anIndex]->index = anIndex;
+    mPlayers.pop_back();
+
+    // Forget the property handles of theEntity
+    mNetworkProperties.erase(anIter);
+
+    // Let GetRemoteProperties forget theEntity as well
+    mRemotesDirty = true;
+  }
+}
+
+NetworkSystem::NetworkProperties& NetworkSystem::GetNetworkProperties(GQE::IEntity* theEntity)
+{
+  // Find the property handles, resolving them the first time theEntity is used
+  std::map<const GQE::typeEntityID, NetworkProperties>::iterator anIter =
+    mNetworkProperties.find(theEntity->GetID());
+  if(anIter == mNetworkProperties.end())
+  {
+    anIter = mNetworkProperties.insert(std::make_pair(theEntity->GetID(), NetworkProperties())).first;
+    NetworkProperties& anProperties = anIter->second;
+    anProperties.entity = theEntity;
+    anProperties.index = mPlayers.size();
+    mPlayers.push_back(&anProperties);
+    anProperties.local.Resolve(theEntity, "bNetworkLocal");
+    anProperties.networkID.Resolve(theEntity, "uNetworkID");
+    anProperties.networkAddr.Resolve(theEntity, "sNetworkAddr");
+    anProperties.networkPort.Resolve(theEntity, "uNetworkPort");
+    anProperties.speed.Resolve(theEntity, "fSpeed");
+    anProperties.keyState.Resolve(theEntity, "uKeyState");
+    anProperties.keyStatePrevious.Resolve(theEntity, "uKeyStatePrevious");
+    anProperties.keyStateValid.Resolve(theEntity, "bKeyState");
+    anProperties.velocity.Resolve(theEntity, "vVelocity");
+    anProperties.position.Resolve(theEntity, "vPosition");
+    anProperties.screen.Resolve(theEntity, "wScreen");
+    anProperties.loading.Resolve(theEntity, "bLoading");
+    anProperties.spriteRect.Resolve(theEntity, "rSpriteRect");
+
+    // No input has been committed for any game tick yet
+    for(unsigned int anSlot = 0; anSlot < INPUT_WINDOW; anSlot++)
+    {
+      anProperties.inputs[anSlot].tick = 0;
+      anProperties.inputs[anSlot].keyState = 0;
+      anProperties.inputs[anSlot].stateTick = 0;
+      anProperties.inputs[anSlot].simulatedTick = 0;
+      anProperties.inputs[anSlot].simulated = 0;
+    }
+    anProperties.lastKeyState = 0;
+    anProperties.ack = 0;
+  }
+
+  // Return the property handles of theEntity
+  return anIter->second;
 }
 
-void NetworkSystem::ProcessInput(GQE::IEntity* theEntity)
+NetworkSystem::NetworkProperties* NetworkSystem::GetRemoteProperties(GQE::Uint32 theNetworkID)
 {
-  if(theEntity->mProperties.Get<bool>("bKeyState"))
+  std::map<const GQE::Uint32, NetworkProperties*>::iterator anIter =
+    mRemotes.find(theNetworkID);
+
+  // A remote player found under an old uNetworkID means it has changed
+  if(anIter != mRemotes.end() && anIter->second->networkID.Get() != theNetworkID)
+  {
+    mRemotesDirty = true;
+  }
+
+  // Remake our index only after an IEntity was added or dropped or a
+  // uNetworkID changed, uNetworkID is set by the IState after HandleInit
+  // has been called so the index is made on first use
+  if(mRemotesDirty)
+  {
+    mRemotesDirty = false;
+    mRemotes.clear();
+    for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    {
+      if(mPlayers[anIndex]->local.Get() == false)
+      {
+        mRemotes[mPlayers[anIndex]->networkID.Get()] = mPlayers[anIndex];
+      }
+    } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+    anIter = mRemotes.find(theNetworkID);
+  }
+
+  // Return the remote player found or NULL if there isn't one
+  return (anIter != mRemotes.end()) ? anIter->second : NULL;
+}
+
+unsigned int NetworkSystem::GetOldestAck(void) const
+{
+  // Start with the newest game tick local input can be committed for
+  unsigned int anResult = mGameTick + mInputDelay;
+
+  // Find the oldest game tick confirmed by every remote player
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    if(mPlayers[anIndex]->local.Get() == false && mPlayers[anIndex]->ack < anResult)
+    {
+      anResult = mPlayers[anIndex]->ack;
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+
+  // Return the oldest game tick confirmed by every remote player
+  return anResult;
+}
+
+void NetworkSystem::ProcessInput(NetworkProperties& theProperties)
+{
+  if(theProperties.keyStateValid.Get())
   {
     // Get the current KeyState information and process it now
-    GQE::Uint32 anKeyState = theEntity->mProperties.Get<GQE::Uint32>("uKeyState");
+    GQE::Uint32 anKeyState = theProperties.keyState.Get();
 
     // Get the RenderSystem properties we use in ControlSystem
-    sf::IntRect anSpriteRect = theEntity->mProperties.Get<sf::IntRect>("rSpriteRect");
+    sf::IntRect anSpriteRect = theProperties.spriteRect.Get();
 
     // Get the current control system properties from this IEntity
-    float anSpeed = theEntity->mProperties.Get<float>("fSpeed");
+    float anSpeed = theProperties.speed.Get();
 
     // Create a velocity vector to fill as we process keyboard input
     sf::Vector2f anVelocity(0.0f, 0.0f);
@@ -370,32 +496,55 @@ void NetworkSystem::ProcessInput(GQE::IEntity* theEntity)
     }
 
     // Now update the control system properties for this IEntity
-    theEntity->mProperties.Set<sf::Vector2f>("vVelocity", anVelocity);
-    theEntity->mProperties.Set<sf::IntRect>("rSpriteRect", anSpriteRect);
+    theProperties.velocity.Set(anVelocity);
+    theProperties.spriteRect.Set(anSpriteRect);
 
     // Keystate was processed and is no longer valid
-    theEntity->mProperties.Set<bool>("bKeyState", false);
+    theProperties.keyStateValid.Set(false);
   }
   else
   {
     WLOG() << "NetworkSystem::ProcessInput() missing input for id=" <<
-      theEntity->mProperties.Get<GQE::Uint32>("uNetworkID") << std::endl;
+      theProperties.networkID.Get() << std::endl;
+  }
+}
+
+GQE::Uint16 NetworkSystem::PackPosition(float thePosition)
+{
+  // Round to the nearest fraction of a pixel that fits in 16 bits
+  float anValue = std::floor(thePosition * POSITION_SCALE + 0.5f);
+  if(anValue < -32768.0f)
+  {
+    anValue = -32768.0f;
+  }
+  else if(anValue > 32767.0f)
+  {
+    anValue = 32767.0f;
   }
+
+  // Return the two's complement bits of the rounded value
+  return (GQE::Uint16)(GQE::Int16)anValue;
 }
 
-void NetworkSystem::ProcessVelocity(GQE::IEntity* theEntity)
+float NetworkSystem::UnpackPosition(GQE::Uint16 theValue)
+{
+  // Return the position in pixels from the two's complement bits
+  return (float)(GQE::Int16)theValue / POSITION_SCALE;
+}
+
+void NetworkSystem::ProcessVelocity(NetworkProperties& theProperties)
 {
   // Get the LevelSystem properties
-  sf::Vector2f anPosition = theEntity->mProperties.Get<sf::Vector2f>("vPosition");
+  sf::Vector2f anPosition = theProperties.position.Get();
 
   // Get the NetworkSystem properties
-  sf::Vector2f anVelocity = theEntity->mProperties.Get<sf::Vector2f>("vVelocity");
+  sf::Vector2f anVelocity = theProperties.velocity.Get();
 
   // Now update the current movement properties
   anPosition += anVelocity;
 
   // Now update the RenderSystem properties of this IEntity class
-  theEntity->mProperties.Set<sf::Vector2f>("vPosition", anPosition);
+  theProperties.position.Set(anPosition);
 }
 
 void NetworkSystem::ReceiveRemoteInput(void)
@@ -404,7 +553,9 @@ void NetworkSystem::ReceiveRemoteInput(void)
 
   // Attempt to receive packets from remote players
   do {
-    sf::Packet anData;
+    // Room for more than the largest input packet so larger packets can be noticed
+    GQE::Uint8 anData[PACKET_MAX_SIZE + 1];
+    std::size_t anSize = 0;
 #if (SFML_VERSION_MAJOR < 2)
     sf::IPAddress anRemoteAddr;
 #else
@@ -414,217 +565,168 @@ void NetworkSystem::ReceiveRemoteInput(void)
   
 #if (SFML_VERSION_MAJOR < 2)
     // See if a packet can be received on our client socket
-    anResult = mClient.Receive(anData, anRemoteAddr, anRemotePort);
+    anResult = mClient.Receive(reinterpret_cast<char*>(anData), sizeof(anData), anSize,
+      anRemoteAddr, anRemotePort);
 #else
     // See if a packet can be received on our client socket
-    anResult = mClient.receive(anData, anRemoteAddr, anRemotePort);
+    anResult = mClient.receive(anData, sizeof(anData), anSize, anRemoteAddr, anRemotePort);
 #endif
 
-    // Process packet if one was received
-    if(anResult == sf::Socket::Done)
+    // Process packet if one was received, anything but an input packet of
+    // our version is thrown away
+    if(anResult == sf::Socket::Done && anSize >= PACKET_HEADER &&
+        anSize <= PACKET_MAX_SIZE && anData[0] == PACKET_VERSION)
     {
-      std::string anTemp;
-      unsigned int anCurGameTick;
-      GQE::Uint32 anID;
-      std::string anAddr;
-      unsigned short anPort;
-      GQE::Uint32 anCurKeyState;
-      sf::Vector2f anCurPosition;
-      sf::Vector2u anCurScreen;
-      bool anCurLoading;
-      unsigned int anPrevGameTick;
-      GQE::Uint32 anPrevKeyState;
-      sf::Vector2f anPrevPosition;
-      sf::Vector2u anPrevScreen;
-      bool anPrevLoading;
-      
-      // First receive our current game tick value
-      anData >> anCurGameTick;
-      // Next receive the remote client ID value
-      anData >> anID;
-      // Next receive the remote client IP Address
-      anData >> anAddr;
-      // Next receive the remote client port
-      anData >> anPort;
-      // Next receive the remote client keystate information
-      anData >> anCurKeyState;
-      // Next receive the remote client position information
-      anData >> anTemp;
-      anCurPosition = GQE::ParseVector2f(anTemp, sf::Vector2f(512.0f,384.0f));
-      // Next receive the remote client screen information
-      anData >> anTemp;
-      anCurScreen = GQE::ParseVector2u(anTemp, sf::Vector2u(0,0));
-      // Next receive the remote client loading state
-      anData >> anCurLoading;
-      // Next receive the remote clients previous game tick value
-      anData >> anPrevGameTick;
-      // Next receive the remote client previous keystate information
-      anData >> anPrevKeyState;
-      // Next receive the remote client previous position information
-      anData >> anTemp;
-      anPrevPosition = GQE::ParseVector2f(anTemp, sf::Vector2f(512.0f,384.0f));
-      // Next receive the remote client previous screen information
-      anData >> anTemp;
-      anPrevScreen = GQE::ParseVector2u(anTemp, sf::Vector2u(0,0));
-      // Next receive the remote client previous loading state
-      anData >> anPrevLoading;
-      
-      // Is this the game tick we are looking for?
-      if(anCurGameTick == mGameTick)
+      // The remote game tick is never far from ours, only its low 16 bits are sent
+      const unsigned int anGameTick = mGameTick +
+        (GQE::Int16)(GetUint16(anData + 1) - (GQE::Uint16)(mGameTick & 0xFFFF));
+
+      // Find the remote player this belongs to and update its keystate information
+      NetworkProperties* anProperties = GetRemoteProperties(GetUint32(anData + 3));
+      if(anProperties != NULL)
       {
-        // Search through each z-order map to find theEntity this belongs to
-        std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-        anIter = mEntities.begin();
-        while(anIter != mEntities.end())
+        // Let the system know if this player is currently loading still,
+        // unless the packet is older than the game ticks we might roll back
+        if(anGameTick + INPUT_WINDOW >= mGameTick)
         {
-          std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-          while(anQueue != anIter->second.end())
-          {
-            // Get the IEntity address first
-            GQE::IEntity* anEntity = *anQueue;
+          anProperties->loading.Set((anData[7] & PACKET_LOADING) != 0);
+        }
 
-            // Increment the IEntity iterator second
-            anQueue++;
+        // Keep where this player starts the game tick after its game tick
+        const unsigned int anStateTick = anGameTick + 1;
+        if(anStateTick > mConfirmedTick && anStateTick <= mConfirmedTick + INPUT_WINDOW)
+        {
+          NetworkInput& anInput = anProperties->inputs[anStateTick & (INPUT_WINDOW - 1)];
+          anInput.stateTick = anStateTick;
+          anInput.position.x = UnpackPosition(GetUint16(anData + 8));
+          anInput.position.y = UnpackPosition(GetUint16(anData + 10));
+          anInput.screen.x = anData[12];
+          anInput.screen.y = anData[13];
+        }
 
-            // Is this the player we just received a packet for? then update its keystate information
-            if(anEntity->mProperties.Get<GQE::Uint32>("uNetworkID") == anID)
-            {
-              // Make note of the keystate information
-              anEntity->mProperties.Set<GQE::Uint32>("uKeyState", anCurKeyState);
-              // Let the system know this player has already provided keystate information
-              anEntity->mProperties.Set<bool>("bKeyState", true);
-              // Let the system know this players current position information
-              anEntity->mProperties.Set<sf::Vector2f>("vPosition", anCurPosition);
-              // Let the system know this players current screen information
-              anEntity->mProperties.Set<sf::Vector2u>("wScreen", anCurScreen);
-              // Let the system know if this player is currently loading still
-              anEntity->mProperties.Set<bool>("bLoading", anCurLoading);
-            }
-          } // while(anQueue != anIter->second.end())
+        // Remember the newest game tick this player confirmed, it no longer
+        // needs our input for it or any game tick before it
+        const unsigned int anAck = anGameTick - anData[15];
+        if(anAck > anProperties->ack && anAck <= mGameTick + mInputDelay)
+        {
+          anProperties->ack = anAck;
+        }
 
-          // Increment map iterator
-          anIter++;
-        } //while(anIter != mEntities.end())
-      } //if(anCurGameTick == mGameTick)
-      else if(anPrevGameTick == mGameTick)
-      {
-        // Search through each z-order map to find theEntity this belongs to
-        std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-        anIter = mEntities.begin();
-        while(anIter != mEntities.end())
+        // Keep the keystate of each game tick we haven't confirmed yet, this
+        // fills in every game tick lost with an earlier packet
+        const unsigned int anNewest = anGameTick + anData[14];
+        unsigned int anTick = anNewest + 1 - anData[16];
+        for(std::size_t anRun = PACKET_HEADER; anRun + 1 < anSize; anRun += 2)
         {
-          std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-          while(anQueue != anIter->second.end())
+          for(GQE::Uint8 anLength = 0; anLength < anData[anRun] && anTick <= anNewest; anLength++)
           {
-            // Get the IEntity address first
-            GQE::IEntity* anEntity = *anQueue;
-
-            // Increment the IEntity iterator second
-            anQueue++;
-
-            // Is this the player we just received a packet for? then update its keystate information
-            if(anEntity->mProperties.Get<GQE::Uint32>("uNetworkID") == anID)
+            NetworkInput& anInput = anProperties->inputs[anTick & (INPUT_WINDOW - 1)];
+            if(anTick > mConfirmedTick && anTick <= mConfirmedTick + INPUT_WINDOW &&
+                anInput.tick != anTick)
             {
-              // Make note of the keystate information
-              anEntity->mProperties.Set<GQE::Uint32>("uKeyState", anPrevKeyState);
-              // Let the system know this player has already provided keystate information
-              anEntity->mProperties.Set<bool>("bKeyState", true);
-              // Let the system know this players previous position information
-              anEntity->mProperties.Set<sf::Vector2f>("vPosition", anPrevPosition);
-              // Let the system know this players previous screen information
-              anEntity->mProperties.Set<sf::Vector2u>("wScreen", anPrevScreen);
-              // Let the system know if this player is currently loading still
-              anEntity->mProperties.Set<bool>("bLoading", anPrevLoading);
+              anInput.tick = anTick;
+              anInput.keyState = anData[anRun + 1];
+
+              // Did we already act on this game tick with other input?
+              if(anInput.simulatedTick == anTick && anInput.simulated != anInput.keyState &&
+                  (mRollbackTick == 0 || anTick < mRollbackTick))
+              {
+                mRollbackTick = anTick;
+              }
             }
-          } // while(anQueue != anIter->second.end())
 
-          // Increment map iterator
-          anIter++;
-        } //while(anIter != mEntities.end())
+            // Move on to the next game tick of this run
+            anTick++;
+          }
+        } // for(std::size_t anRun = PACKET_HEADER; anRun + 1 < anSize; anRun += 2)
       }
-    } //if(anResult == sf::Socket::Done)
+    } //if(anResult == sf::Socket::Done && ...)
   } while(anResult == sf::Socket::Done);
 }
 
-void NetworkSystem::SendLocalInput(GQE::IEntity* theEntity)
+void NetworkSystem::SendLocalInput(NetworkProperties& theProperties)
 {
-  // Packet for sending our local players KeyState information to this network player
-  sf::Packet anData;
+  // Packet for sending our local players KeyState information to each
+  // network player, see PACKET_HEADER for its layout
+  GQE::Uint8 anData[PACKET_MAX_SIZE];
 
-  // Prepare a packet for this local player to send to all remote players
-  // Start with current game tick number
-  anData << mGameTick;
+  // Start with the packet version and the low 16 bits of our game tick
+  anData[0] = PACKET_VERSION;
+  PutUint16(anData + 1, (GQE::Uint16)(mGameTick & 0xFFFF));
   // Add Network ID of the local player
-  anData << theEntity->mProperties.Get<GQE::Uint32>("uNetworkID");
-#if (SFML_VERSION_MAJOR < 2)
-  // Add IP Address of the local player
-  anData << theEntity->mProperties.Get<sf::IPAddress>("sNetworkAddr").ToString();
-#else
-  // Add IP Address of the local player
-  anData << theEntity->mProperties.Get<sf::IpAddress>("sNetworkAddr").toString();
-#endif
-  // Add port number of the local player
-  anData << theEntity->mProperties.Get<unsigned short>("uNetworkPort");
-  // Add the current uKeyState property
-  anData << theEntity->mProperties.Get<GQE::Uint32>("uKeyState");
-  // Add the current vPosition property
-  anData << GQE::ConvertVector2f(theEntity->mProperties.Get<sf::Vector2f>("vPosition"));
-  // Add the current wScreen property
-  anData << GQE::ConvertVector2u(theEntity->mProperties.Get<sf::Vector2u>("wScreen"));
+  PutUint32(anData + 3, theProperties.networkID.Get());
   // Add the current bLoading property
-  anData << theEntity->mProperties.Get<bool>("bLoading");
-  // Add the previous game tick number
-  anData << mGameTick - 1;
-  // Add the previous uKeyState property
-  anData << theEntity->mProperties.Get<GQE::Uint32>("uKeyStatePrevious");
-  // Add the current vPosition property
-  anData << GQE::ConvertVector2f(theEntity->mProperties.Get<sf::Vector2f>("vPositionPrevious"));
-  // Add the current wScreen property
-  anData << GQE::ConvertVector2u(theEntity->mProperties.Get<sf::Vector2u>("wScreenPrevious"));
-  // Add the previous bLoading property
-  anData << theEntity->mProperties.Get<bool>("bLoadingPrevious");
-
-  // The iterator to use for each z-ordered deque of IEntity classes
-  std::map<const GQE::Uint32, std::deque<GQE::IEntity*> >::iterator anIter;
-  
-  // Now loop through and send this to each remote player
-  anIter = mEntities.begin();
-  while(anIter != mEntities.end())
+  anData[7] = theProperties.loading.Get() ? PACKET_LOADING : 0;
+  // Add the vPosition and wScreen properties the next game tick starts from
+  PutUint16(anData + 8, PackPosition(theProperties.position.Get().x));
+  PutUint16(anData + 10, PackPosition(theProperties.position.Get().y));
+  anData[12] = (GQE::Uint8)theProperties.screen.Get().x;
+  anData[13] = (GQE::Uint8)theProperties.screen.Get().y;
+
+  // Find the newest committed game tick and the committed game ticks before
+  // it that some remote player hasn't confirmed yet, UpdateLocalInput never
+  // commits more of them than fit in INPUT_WINDOW
+  unsigned int anNewest = mGameTick + mInputDelay;
+  while(anNewest > mGameTick &&
+      theProperties.inputs[anNewest & (INPUT_WINDOW - 1)].tick != anNewest)
+  {
+    anNewest--;
+  }
+  const unsigned int anAck = GetOldestAck();
+  unsigned int anCount = 0;
+  while(anCount < INPUT_WINDOW && anNewest - anCount > anAck &&
+      theProperties.inputs[(anNewest - anCount) & (INPUT_WINDOW - 1)].tick == anNewest - anCount)
+  {
+    anCount++;
+  }
+  anData[14] = (GQE::Uint8)(anNewest - mGameTick);
+  anData[15] = (GQE::Uint8)(mGameTick - mConfirmedTick);
+  anData[16] = (GQE::Uint8)anCount;
+
+  // Add runs of committed game ticks with the same uKeyState, oldest first
+  std::size_t anSize = PACKET_HEADER;
+  for(unsigned int anTick = anNewest + 1 - anCount; anTick <= anNewest; anTick++)
   {
-    std::deque<GQE::IEntity*>::iterator anQueue = anIter->second.begin();
-    while(anQueue != anIter->second.end())
+    const GQE::Uint8 anKeyState =
+      (GQE::Uint8)(theProperties.inputs[anTick & (INPUT_WINDOW - 1)].keyState & KEY_MASK);
+    if(anSize > PACKET_HEADER && anData[anSize - 1] == anKeyState)
+    {
+      anData[anSize - 2]++;
+    }
+    else
     {
-      // Get the IEntity address first
-      GQE::IEntity* anEntity = *anQueue;
+      anData[anSize] = 1;
+      anData[anSize + 1] = anKeyState;
+      anSize += 2;
+    }
+  }
 
-      // Increment the IEntity iterator second
-      anQueue++;
+  // Now loop through and send this to each remote player
+  for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
+  {
+    // Get the property handles of this player
+    NetworkProperties& anRemote = *mPlayers[anIndex];
 
-      // If this is us, just move on
-      if(anEntity == theEntity)
-        continue;
+    // If this is us, just move on
+    if(&anRemote == &theProperties)
+      continue;
 
-      // Are we a local player who needs to send our keyboard state?
-      if(anEntity->mProperties.Get<bool>("bNetworkLocal") == false)
-      {
+    // Are we a local player who needs to send our keyboard state?
+    if(anRemote.local.Get() == false)
+    {
 #if (SFML_VERSION_MAJOR < 2)
-        // Now send our local players keystate to this network client
-        mClient.Send(anData, anEntity->mProperties.Get<sf::IPAddress>("sNetworkAddr"),
-          anEntity->mProperties.Get<unsigned short>("uNetworkPort"));
+      // Now send our local players keystate to this network client
+      mClient.Send(reinterpret_cast<const char*>(anData), anSize,
+        anRemote.networkAddr.Get(), anRemote.networkPort.Get());
 #else
-        // Now send our local players keystate to this network client
-        mClient.send(anData, anEntity->mProperties.Get<sf::IpAddress>("sNetworkAddr"),
-          anEntity->mProperties.Get<unsigned short>("uNetworkPort"));
+      // Now send our local players keystate to this network client
+      mClient.send(anData, anSize, anRemote.networkAddr.Get(), anRemote.networkPort.Get());
 #endif
-      }
-    } // while(anQueue != anIter->second.end())
-
-    // Increment map iterator
-    anIter++;
-  } //while(anIter != mEntities.end())
+    }
+  } // for(size_t anIndex = 0; anIndex < mPlayers.size(); anIndex++)
 }
 
-void NetworkSystem::UpdateLocalInput(GQE::IEntity* theEntity)
+void NetworkSystem::UpdateLocalInput(NetworkProperties& theProperties)
 {
   // Start with no keys being pressed
   GQE::Uint32 anKeyState = 0;
@@ -665,9 +767,22 @@ void NetworkSystem::UpdateLocalInput(GQE::IEntity* theEntity)
   }
 #endif
 
-  // Update the control system properties for this local Entity
-  theEntity->mProperties.Set<GQE::Uint32>("uKeyState", anKeyState);
-  theEntity->mProperties.Set<bool>("bKeyState", true);
+  // Commit the keyboard state for each game tick up to mInputDelay ahead,
+  // unless its slot still holds input some remote player hasn't confirmed
+  unsigned int anLast = mGameTick + mInputDelay;
+  if(anLast > GetOldestAck() + INPUT_WINDOW)
+  {
+    anLast = GetOldestAck() + INPUT_WINDOW;
+  }
+  for(unsigned int anTick = mGameTick + 1; anTick <= anLast; anTick++)
+  {
+    NetworkInput& anInput = theProperties.inputs[anTick & (INPUT_WINDOW - 1)];
+    if(anInput.tick != anTick)
+    {
+      anInput.tick = anTick;
+      anInput.keyState = anKeyState;
+    }
+  }
 }
 
 /**
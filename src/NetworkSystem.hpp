@@ -5,13 +5,26 @@
  * @author Ryan Lindeman
  * @date 20120712 - Initial Release
  * @date 20120730 - Improved network synchronization for multiplayer game play
+ * @date 20261016 - Use cached property handles instead of string lookups
+ * @date 20261016 - Keep a dense array of registered IEntity classes
+ * @date 20261016 - Simulate one game tick every fixed update
+ * @date 20261016 - Send input packets in a compact binary layout
+ * @date 20261016 - Find remote players by uNetworkID without a search
+ * @date 20261016 - Send a window of input ticks in every input packet
+ * @date 20261016 - Predict remote input and roll back on late input
+ * @date 20261016 - Never commit input a remote player can no longer be sent
+ * @date 20261016 - Only load a new map once every game tick is confirmed
  */
 #ifndef NETWORK_SYSTEM_HPP_INCLUDED
 #define NETWORK_SYSTEM_HPP_INCLUDED
 
+#include <map>
+#include <vector>
 #include <SFML/Network.hpp>
 #include <GQE/Entity/interfaces/ISystem.hpp>
 #include <GQE/Entity/classes/Prototype.hpp>
+#include "PropertyHandle.hpp"
+#include "LevelSystem.hpp"
 
 // Forward declare the TnTApp class
 class TnTApp;
@@ -19,7 +32,7 @@ class TnTApp;
 class NetworkSystem : public GQE::ISystem
 {
   public:
-    NetworkSystem(TnTApp& theApp);
+    NetworkSystem(TnTApp& theApp, LevelSystem& theLevelSystem);
 
     virtual ~NetworkSystem();
 
@@ -39,10 +52,25 @@ class NetworkSystem : public GQE::ISystem
     /**
      * UpdateFixed is called a specific number of times every game loop and
      * this method will allow each Instance class a chance to have its
-     * UpdateFixed method called for each game loop iteration.
+     * UpdateFixed method called for each game loop iteration. The next game
+     * tick is simulated as soon as our local players committed input for it,
+     * predicting the input of remote players up to PREDICT_TICKS game ticks
+     * ahead of the last confirmed game tick. Remote input that arrives late
+     * and differs from what was predicted rolls every player back to the
+     * state saved for that game tick and simulates it again. Nothing is
+     * predicted while a new map is pending, it is loaded by LevelSystem
+     * once every game tick simulated has been confirmed.
      */
     virtual void UpdateFixed(void);
 
+    /**
+     * CommitLocalInput is called after every other ISystem has had its
+     * UpdateFixed method called. The input of each local player is committed
+     * and sent for the next game tick, so it is on its way to the remote
+     * players before the next fixed update.
+     */
+    void CommitLocalInput(void);
+
     /**
      * UpdateVariable is called every time the game loop draws a frame and
      * includes the elapsed time between the last UpdateVariable call for
@@ -60,15 +88,6 @@ class NetworkSystem : public GQE::ISystem
      */
     virtual void Draw(void);
   protected:
-    /// Network UpdateFixed processing steps
-    enum UpdateFixedStep {
-      ActionWait      = 0, ///< Wait for other players to finish loading a new level
-      ActionCommit    = 1, ///< Local players commit their keystate information
-      ActionBroadcast = 2, ///< Send local keystate info and get remote keystate info
-      ActionVelocity  = 3, ///< Create velocity values using keystate information
-      ActionPosition  = 4  ///< Use velocity values to cause position changes
-    };
-
     /**
      * HandleInit is called to allow each derived ISystem to perform any
      * initialization steps when a new IEntity is added.
@@ -92,12 +111,84 @@ class NetworkSystem : public GQE::ISystem
     static const unsigned int KEY_RIGHT = 0x00000008; // Right key is being pressed
     static const unsigned int KEY_SPACE = 0x00000010; // Spacebar key is being pressed
     static const unsigned int KEY_ENTER = 0x00000020; // Enter key is being pressed
+    static const unsigned int KEY_MASK  = 0x0000003F; // Every key sent in an input packet
+
+    // Local input is committed INPUT_DELAY game ticks ahead so a few lost
+    // packets are made up for by the next ones before anyone has to wait
+    static const unsigned int INPUT_DELAY = 3;  // Game ticks local input is committed ahead
+    static const unsigned int INPUT_WINDOW = 8; // Game ticks of input kept and sent, a power of 2
+
+    // Remote input is predicted up to PREDICT_TICKS game ticks past the last
+    // game tick every player confirmed, then we wait like lockstep does. Use
+    // 0 to never predict and commit local input INPUT_DELAY game ticks ahead
+    // instead. Must be less than INPUT_WINDOW since every game tick after the
+    // confirmed one needs its input and saved state kept until confirmed.
+    static const unsigned int PREDICT_TICKS = 6; // Game ticks remote input is predicted ahead
+
+    // Input packets are PACKET_HEADER bytes (version, low 16 bits of the game
+    // tick, network ID, packet flags, position x and y and screen x and y at
+    // the start of the next game tick, offset of the newest committed game
+    // tick, offset back to the confirmed game tick and the number of committed
+    // game ticks sent) followed by runs of committed game ticks, oldest first,
+    // of 2 bytes each (game ticks in the run and the uKeyState of each of them)
+    static const GQE::Uint8 PACKET_VERSION = 3;   // Bump on every packet layout change
+    static const unsigned int PACKET_HEADER = 17; // Bytes before the first run
+    static const unsigned int PACKET_MAX_SIZE = PACKET_HEADER + 2 * INPUT_WINDOW;
+    static const GQE::Uint8 PACKET_LOADING = 0x01; // Packet flag for bLoading
+    static const unsigned int POSITION_SCALE = 16; // Fractions of a pixel each position is sent in
+
+    // Struct to hold the input a player committed for one game tick
+    typedef struct sNetworkInput {
+      unsigned int                     tick;             ///< The game tick keyState is for
+      GQE::Uint32                      keyState;         ///< The uKeyState to act on
+      unsigned int                     stateTick;        ///< The game tick position and screen are for
+      sf::Vector2f                     position;         ///< The vPosition to start from
+      sf::Vector2u                     screen;           ///< The wScreen to start from
+      unsigned int                     simulatedTick;    ///< The game tick simulated is for
+      GQE::Uint32                      simulated;        ///< The uKeyState last simulated with
+    } NetworkInput;
+
+    // Struct to hold the property handles of a registered IEntity, resolved
+    // once by HandleInit so UpdateFixed never looks them up by name
+    typedef struct sNetworkProperties {
+      GQE::IEntity*                    entity;           ///< The IEntity these handles belong to
+      size_t                           index;            ///< Index of this IEntity in mPlayers
+      TPropertyHandle<bool>            local;            ///< bNetworkLocal
+      TPropertyHandle<GQE::Uint32>     networkID;        ///< uNetworkID
+#if (SFML_VERSION_MAJOR < 2)
+      TPropertyHandle<sf::IPAddress>   networkAddr;      ///< sNetworkAddr
+#else
+      TPropertyHandle<sf::IpAddress>   networkAddr;      ///< sNetworkAddr
+#endif
+      TPropertyHandle<unsigned short>  networkPort;      ///< uNetworkPort
+      TPropertyHandle<float>           speed;            ///< fSpeed
+      TPropertyHandle<GQE::Uint32>     keyState;         ///< uKeyState
+      TPropertyHandle<GQE::Uint32>     keyStatePrevious; ///< uKeyStatePrevious
+      TPropertyHandle<bool>            keyStateValid;    ///< bKeyState
+      TPropertyHandle<sf::Vector2f>    velocity;         ///< vVelocity
+      TPropertyHandle<sf::Vector2f>    position;         ///< vPosition
+      TPropertyHandle<sf::Vector2u>    screen;           ///< wScreen
+      TPropertyHandle<bool>            loading;          ///< bLoading
+      TPropertyHandle<sf::IntRect>     spriteRect;       ///< rSpriteRect
+      NetworkInput                     inputs[INPUT_WINDOW]; ///< Input committed by game tick
+      GQE::Uint32                      lastKeyState;     ///< uKeyState of the confirmed game tick
+      unsigned int                     ack;              ///< Newest game tick a remote player confirmed
+    } NetworkProperties;
+
     // Variables
     /////////////////////////////////////////////////////////////////////////
-    /// The current step to use during UpdateFixed
-    UpdateFixedStep mUpdateStep;
     /// The game tick value incremented every time we act on input
     unsigned int mGameTick;
+    /// The newest game tick simulated with the input of every player
+    unsigned int mConfirmedTick;
+    /// The oldest game tick simulated with mispredicted input or 0 if none
+    unsigned int mRollbackTick;
+    /// Game ticks local input is committed ahead, see PREDICT_TICKS
+    const unsigned int mInputDelay;
+    /// The LevelSystem that moves every player each game tick
+    LevelSystem& mLevelSystem;
+    /// The state saved at the start of each game tick after mConfirmedTick
+    LevelSystem::LevelState mStates[INPUT_WINDOW];
 #if (SFML_VERSION_MAJOR < 2)
     /// The client socket for the local player
     sf::SocketUDP& mClient;
@@ -105,47 +196,117 @@ class NetworkSystem : public GQE::ISystem
     /// The client socket for the local player
     sf::UdpSocket& mClient;
 #endif
+    /// The property handles of each registered IEntity
+    std::map<const GQE::typeEntityID, NetworkProperties> mNetworkProperties;
+    /// Every registered IEntity in no particular order, for looping over them
+    std::vector<NetworkProperties*> mPlayers;
+    /// Every remote player in mPlayers by uNetworkID, see GetRemoteProperties
+    std::map<const GQE::Uint32, NetworkProperties*> mRemotes;
+    /// True if mRemotes must be remade before it is used again
+    bool mRemotesDirty;
+
+    /**
+     * GetNetworkProperties returns the property handles for theEntity
+     * provided, resolving them and adding theEntity to mPlayers the first
+     * time theEntity is used.
+     * @param[in] theEntity to return the property handles for
+     * @return the property handles for theEntity
+     */
+    NetworkProperties& GetNetworkProperties(GQE::IEntity* theEntity);
+
+    /**
+     * GetRemoteProperties returns the property handles of the remote player
+     * using theNetworkID provided. The index of remote players is only
+     * remade when an IEntity was added or dropped or the uNetworkID of a
+     * remote player found no longer matches, packets from unknown senders
+     * never remake it.
+     * @param[in] theNetworkID of the remote player to find
+     * @return the property handles of the remote player or NULL if not found
+     */
+    NetworkProperties* GetRemoteProperties(GQE::Uint32 theNetworkID);
+
+    /**
+     * GetOldestAck returns the oldest game tick confirmed by every remote
+     * player, local input after it must still be sent to someone.
+     * @return the oldest game tick confirmed by every remote player or the
+     *         newest game tick local input is committed for if there are none
+     */
+    unsigned int GetOldestAck(void) const;
 
     /**
      * ProcessInput is responsible for acting on the uKeyState information
      * stored in theEntity provided. This centralizes the processing of the
      * input into a single method (unifies the old ControlSystem with this
      * NetworkSystem) to better synchronize the multiplayer game scenario.
-     * @param[in] theEntity to process and act on the stored uKeyState info
+     * @param[in] theProperties of the IEntity to process the uKeyState info of
      */
-    void ProcessInput(GQE::IEntity* theEntity);
+    void ProcessInput(NetworkProperties& theProperties);
+
+    /**
+     * SimulateTick is responsible for acting on the input of every player
+     * for theTick provided, using the last input received from a remote
+     * player if it hasn't committed input for theTick yet, and moving every
+     * player with the help of LevelSystem.
+     * @param[in] theTick to simulate
+     * @param[in] theReplay is true if theTick was simulated before
+     */
+    void SimulateTick(unsigned int theTick, bool theReplay);
 
     /**
      * ProcessVelocity is responsible for acting on the vVelocity information
      * stored in theEntity provided. This centralizes the processing of the
      * velocity information into position information to better synchronize
      * the positions in a multiplayer game scenario.
-     * @param[in] theEntity to change position information for
+     * @param[in] theProperties of the IEntity to change position information for
+     */
+    void ProcessVelocity(NetworkProperties& theProperties);
+
+    /**
+     * PackPosition returns thePosition provided as a 16 bit fixed point
+     * value in 1/POSITION_SCALE pixels for sending in an input packet.
+     * @param[in] thePosition in pixels to pack
+     * @return the packed position
+     */
+    static GQE::Uint16 PackPosition(float thePosition);
+
+    /**
+     * UnpackPosition returns the position in pixels of theValue provided
+     * which was packed by PackPosition.
+     * @param[in] theValue to unpack
+     * @return the position in pixels
      */
-    void ProcessVelocity(GQE::IEntity* theEntity);
+    static float UnpackPosition(GQE::Uint16 theValue);
 
     /**
      * ReceiveRemoteInput is responsible for receiving remote entity keystate
-     * information for the current game tick and throwing everything else away.
+     * information for the INPUT_WINDOW game ticks after mConfirmedTick and
+     * throwing everything else away. Every packet fills in any game tick an
+     * earlier lost packet would have provided. Input for a game tick that
+     * was already simulated with different input sets mRollbackTick.
      */
     void ReceiveRemoteInput(void);
 
     /**
-     * SendLocalInput is responsible for sending the uKeyState information to
-     * every registered remote entity.
-     * @param[in] theEntity that is the local entity to send information about
+     * SendLocalInput is responsible for sending the uKeyState information
+     * committed for every game tick a remote player hasn't confirmed yet to
+     * every registered remote entity, along with where the local entity
+     * starts the next game tick from and the game tick we confirmed.
+     * @param[in] theProperties of the local entity to send information about
      */
-    void SendLocalInput(GQE::IEntity* theEntity);
+    void SendLocalInput(NetworkProperties& theProperties);
 
     /**
      * UpdateLocalInput is responsible for collecting local keyboard state
      * information for theEntity provided. This replaces the ControlSystem that
      * was previously used in version 1.0 and 1.1 of TNT so that all control
      * can be centralized into one place and provide better synchonization for
-     * multiplayer games.
-     * @param[in] theEntity to collect and store the local keyboard state info
+     * multiplayer games. The keyboard state is committed for every game tick
+     * up to mInputDelay game ticks ahead that isn't committed yet, but never
+     * more than INPUT_WINDOW game ticks past the oldest game tick confirmed
+     * by every remote player so each of them can still be sent to it.
+     * @param[in] theProperties of the IEntity to store the local keyboard state info in
      */
-    void UpdateLocalInput(GQE::IEntity* theEntity);
+    void UpdateLocalInput(NetworkProperties& theProperties);
 };
 #endif // NETWORK_SYSTEM_HPP_INCLUDED
 
@@ -0,0 +1,105 @@
+/**
+ * Provides the TPropertyHandle class which caches the typed property of an
+ * IEntity so it can be read and written without looking it up by name.
+ *
+ * @file src/PropertyHandle.hpp
+ * @author Ryan Lindeman
+ * @date 20261016 - Initial Release
+ */
+#ifndef PROPERTY_HANDLE_HPP_INCLUDED
+#define PROPERTY_HANDLE_HPP_INCLUDED
+
+#include <cstddef>
+#include <GQE/Entity/interfaces/IEntity.hpp>
+
+/// Provides the cached property handle class
+template<class TYPE>
+class TPropertyHandle
+{
+  public:
+    /**
+     * TPropertyHandle default constructor
+     */
+    TPropertyHandle() :
+      mProperty(NULL)
+    {
+    }
+
+    /**
+     * Resolve will find thePropertyID property of theEntity once so every
+     * Get and Set call afterwards is a pointer dereference. The property
+     * must have been added to theEntity already by some ISystem.
+     * @param[in] theEntity to find the property in
+     * @param[in] thePropertyID of the property to find
+     * @return true if the property was found, false otherwise
+     */
+    bool Resolve(GQE::IEntity* theEntity, const GQE::typePropertyID thePropertyID)
+    {
+      mProperty = NULL;
+      if(theEntity->mProperties.HasID(thePropertyID))
+      {
+        mProperty = theEntity->mProperties.GetProperty<TYPE>(thePropertyID);
+      }
+
+      // Return true if the property was found
+      return mProperty != NULL;
+    }
+
+    /**
+     * Get will return the value of the resolved property or the default
+     * value of TYPE if the property was never found.
+     * @return the value of the property
+     */
+    TYPE Get(void) const
+    {
+      return (mProperty != NULL) ? mProperty->GetValue() : TYPE();
+    }
+
+    /**
+     * Set will change the value of the resolved property, nothing is done if
+     * the property was never found.
+     * @param[in] theValue to set the property to
+     */
+    void Set(TYPE theValue)
+    {
+      if(mProperty != NULL)
+      {
+        mProperty->SetValue(theValue);
+      }
+    }
+
+  private:
+    // Variables
+    /////////////////////////////////////////////////////////////////////////
+    /// The property found by Resolve which is owned by the IEntity
+    GQE::TProperty<TYPE>* mProperty;
+}; // class TPropertyHandle
+#endif // PROPERTY_HANDLE_HPP_INCLUDED
+
+/**
+ * @class TPropertyHandle
+ * The TPropertyHandle class is used by each ISystem to keep the typed
+ * properties of each IEntity it uses every fixed update. Looking a property
+ * up by its string ID walks the property map of the IEntity and compares
+ * strings every time, a handle does that once when the IEntity is added to
+ * the ISystem (see HandleInit) and the property address stays valid until
+ * the IEntity is deleted. Each ISystem must forget its handles for an
+ * IEntity in HandleCleanup.
+ *
+ * @section LICENSE
+ * Traps and Treasures, a multiplayer action adventure game for the LPC contest
+ * Copyright (C) 2012  Ryan Lindeman, Jacob Dix, David Cannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
@@ -13,6 +13,7 @@
 #include "GameState.hpp"
 #include "NetworkState.hpp"
 #include "TmxHandler.hpp"
+#include "LevelHandler.hpp"
 
 TnTApp::TnTApp(const std::string theTitle) :
   GQE::IApp(theTitle),
@@ -68,6 +69,7 @@ TnTApp::~TnTApp()
 void TnTApp::InitAssetHandlers()
 {
   mAssetManager.RegisterHandler(new(std::nothrow) TmxHandler());
+  mAssetManager.RegisterHandler(new(std::nothrow) LevelHandler());
 }
 
 void TnTApp::InitScreenFactory()